@@ -0,0 +1,101 @@
+#include <vector>
+#include <array>
+#include <string>
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <cstdint>
+
+#include "../common/grid_bfs.hpp"
+
+// Single-pair shortest path, one-sided against bidirectional layered BFS (gridbfs), on generated
+// mazes: a braided maze (perfect maze with a share of extra openings), the same maze with random
+// portal pairs, and the portals with day20-style recursive levels.
+// Build: g++ -std=c++20 -O2 bench/bidirectional.cpp
+// Run:   ./a.out [side=2048] [portal pairs=64] [braid=0.1]
+
+namespace {
+
+gridbfs::Grid generateMaze(int side, double braid, std::mt19937& rng) {
+    gridbfs::Grid grid(side, side);
+    std::vector<uint32_t> stack = { grid.index(0, 0) };
+    grid[stack.back()] = '.';
+    while (!stack.empty()) {
+        const auto cell = stack.back();
+        std::array<int32_t, 4> options;
+        auto count = 0;
+        for (const auto offset : grid.offsets) {
+            const auto next = cell + 2 * offset;
+            if (next < grid.size() && grid[next] == gridbfs::WALL && grid[cell + offset] == gridbfs::WALL
+                && grid.x(next) >= 0 && grid.x(next) < side && grid.y(next) >= 0 && grid.y(next) < side)
+                options[count++] = offset;
+        }
+        if (count == 0) {
+            stack.pop_back();
+            continue;
+        }
+        const auto offset = options[rng() % count];
+        grid[cell + offset] = '.';
+        grid[cell + 2 * offset] = '.';
+        stack.push_back(cell + 2 * offset);
+    }
+    // knock out some interior walls so that there is more than one way around
+    std::bernoulli_distribution knock(braid);
+    for (auto y = 1; y < side - 1; ++y)
+        for (auto x = 1; x < side - 1; ++x)
+            if (grid[grid.index(x, y)] == gridbfs::WALL && knock(rng)) grid[grid.index(x, y)] = '.';
+    return grid;
+}
+
+gridbfs::Portals generatePortals(gridbfs::Grid const& grid, int pairs, std::mt19937& rng) {
+    gridbfs::Portals portals(grid.size());
+    std::vector<uint32_t> open;
+    for (auto cell = 0u; cell < grid.size(); ++cell)
+        if (grid[cell] == '.') open.push_back(cell);
+    for (auto i = 0; i < pairs; ++i) {
+        const auto a = open[rng() % open.size()];
+        const auto b = open[rng() % open.size()];
+        if (a == b || portals.partner[a] != gridbfs::Portals::NONE || portals.partner[b] != gridbfs::Portals::NONE) continue;
+        // one end sits on the "inner ring" (goes down a level), the other on the outer one
+        portals.link(a, b, 1);
+        portals.link(b, a, -1);
+    }
+    return portals;
+}
+
+template <typename F>
+void measure(const char* name, F fun) {
+    auto start = std::chrono::steady_clock::now();
+    const auto result = fun();
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "  " << name << ": distance " << result.distance << ", expanded " << result.expanded << ", "
+              << std::chrono::duration<double>(end - start).count() * 1000 << "ms\n";
+}
+}
+
+int main(int argc, char** argv)
+{
+    const auto side = (argc > 1 ? std::stoi(argv[1]) : 2048) | 1;
+    const auto pairs = argc > 2 ? std::stoi(argv[2]) : 64;
+    const auto braid = argc > 3 ? std::stod(argv[3]) : 0.1;
+
+    std::mt19937 rng(2019);
+    const auto grid = generateMaze(side, braid, rng);
+    auto portals = generatePortals(grid, pairs, rng);
+    const auto start = grid.index(0, 0);
+    const auto goal = grid.index(side - 1, side - 1);
+    const auto open = [](char c) { return c != gridbfs::WALL; };
+
+    const auto run = [&](const char* title, gridbfs::Portals const* p) {
+        std::cout << title << '\n';
+        measure("one-sided    ", [&] { return gridbfs::shortestPath(grid, open, start, goal, p); });
+        measure("bidirectional", [&] { return gridbfs::shortestPathBidirectional(grid, open, start, goal, p); });
+    };
+
+    run("maze", nullptr);
+    run("maze + portals", &portals);
+    portals.recursive = true;
+    portals.maxLevel = pairs;
+    run("maze + recursive portals", &portals);
+    return 0;
+}
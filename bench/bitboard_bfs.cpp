@@ -0,0 +1,112 @@
+#include <vector>
+#include <string>
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <cstdint>
+
+#include "../common/grid_bfs.hpp"
+#include "../common/bitboard_bfs.hpp"
+
+// Flood fill of a large open grid (sparse random rocks): a ring-buffer queue BFS on the padded
+// gridbfs grid against the bit-parallel bitboard BFS, once from a corner and once from a whole row,
+// then one corner-to-centre distance with a single wave against the bidirectional search.
+// Build: g++ -std=c++20 -O2 -mavx2 bench/bitboard_bfs.cpp   (drop -mavx2 for the scalar words)
+// Run:   ./a.out [side=8192] [rock density=0.1]
+
+namespace {
+
+template <typename F>
+double measure(F fun) {
+    auto start = std::chrono::steady_clock::now();
+    fun();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+}
+
+int main(int argc, char** argv)
+{
+    const auto side = argc > 1 ? std::stoi(argv[1]) : 8192;
+    const auto density = argc > 2 ? std::stod(argv[2]) : 0.1;
+
+    gridbfs::Grid grid(side, side, '.');
+    bitboard::Board board(side, side);
+    std::mt19937 rng(2019);
+    std::bernoulli_distribution rock(density);
+    for (auto y = 0; y < side; ++y)
+        for (auto x = 0; x < side; ++x) {
+            if (rock(rng) && (x | y) != 0) grid[grid.index(x, y)] = gridbfs::WALL;
+            else board.set(x, y);
+        }
+
+    // a lone corner source (diagonal front) and a flood from the whole top row (front along rows)
+    for (const auto fromRow : { false, true }) {
+        std::cout << (fromRow ? "-- source: top row\n" : "-- source: corner\n");
+        gridbfs::RingQueue<uint32_t> q;
+        std::vector<int32_t> distance(grid.size(), -1);
+        int32_t levels = 0;
+        uint64_t reached = 0;
+        const auto queueSeconds = measure([&] {
+            for (auto x = 0; x < (fromRow ? side : 1); ++x) {
+                if (grid[grid.index(x, 0)] == gridbfs::WALL) continue;
+                distance[grid.index(x, 0)] = 0;
+                q.push(grid.index(x, 0));
+            }
+            while (!q.empty()) {
+                const auto cell = q.pop();
+                ++reached;
+                levels = distance[cell];
+                for (const auto offset : grid.offsets) {
+                    const auto next = cell + offset;
+                    if (grid[next] == gridbfs::WALL || distance[next] != -1) continue;
+                    distance[next] = distance[cell] + 1;
+                    q.push(next);
+                }
+            }
+        });
+        std::cout << "queue   : " << queueSeconds * 1000 << "ms, " << levels << " levels, " << reached
+                  << " cells, " << reached / queueSeconds / 1e9 << " Gcells/s\n";
+
+        bitboard::Board seeds(side, side);
+        for (auto x = 0; x < (fromRow ? side : 1); ++x)
+            if (board.test(x, 0)) seeds.set(x, 0);
+        bitboard::Stats stats;
+        const auto bitSeconds = measure([&] {
+            stats = bitboard::bfs(board, seeds, [](int, bitboard::Board const&) { return false; });
+        });
+#ifdef __AVX2__
+        const char* name = "bitboard (avx2)";
+#else
+        const char* name = "bitboard (u64)";
+#endif
+        std::cout << name << ": " << bitSeconds * 1000 << "ms, " << stats.levels << " levels, " << stats.reached
+                  << " cells, " << stats.reached / bitSeconds / 1e9 << " Gcells/s reached, "
+                  << stats.sweptCells / bitSeconds / 1e9 << " Gcells/s swept\n";
+    }
+
+    // a single distance, corner to centre: one wave stopping at the target against one from each end
+    {
+        std::cout << "-- path: corner to centre\n";
+        const auto target = side / 2;
+        board.set(target, target);
+        auto oneSided = -1;
+        bitboard::Stats oneStats, twoStats;
+        const auto oneSeconds = measure([&] {
+            oneStats = bitboard::bfs(board, 0, 0, [&](int distance, bitboard::Board const& frontier) {
+                if (!frontier.test(target, target)) return false;
+                oneSided = distance;
+                return true;
+            });
+        });
+        auto twoSided = -1;
+        const auto twoSeconds = measure([&] {
+            twoSided = bitboard::shortestPathBidirectional(board, 0, 0, target, target, &twoStats);
+        });
+        std::cout << "one wave : " << oneSeconds * 1000 << "ms, distance " << oneSided << ", " << oneStats.reached
+                  << " cells, " << oneStats.sweptCells << " swept\n";
+        std::cout << "two waves: " << twoSeconds * 1000 << "ms, distance " << twoSided << ", " << twoStats.reached
+                  << " cells, " << twoStats.sweptCells << " swept\n";
+    }
+    return 0;
+}
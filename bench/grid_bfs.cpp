@@ -0,0 +1,112 @@
+#include <vector>
+#include <set>
+#include <queue>
+#include <tuple>
+#include <array>
+#include <string>
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <cstdint>
+
+#include "../common/grid_bfs.hpp"
+
+// Full-maze BFS on a synthetic perfect maze: the old day18/day20 style (nested vectors,
+// std::set of visited tuples, std::queue of structs) against the gridbfs kernel.
+// Build: g++ -std=c++20 -O2 bench/grid_bfs.cpp
+// Run:   ./a.out [side=4096]
+
+namespace {
+
+using MAP = std::vector<std::vector<char>>;
+
+// randomized depth-first carving on the odd cells, so every open cell is reachable
+MAP generateMaze(int side, uint32_t seed) {
+    MAP maze(side, std::vector<char>(side, '#'));
+    std::mt19937 rng(seed);
+    std::vector<std::pair<int, int>> stack = { { 1, 1 } };
+    maze[1][1] = '.';
+    const std::array<int, 4> dx = { 0, 2, 0, -2 };
+    const std::array<int, 4> dy = { -2, 0, 2, 0 };
+    while (!stack.empty()) {
+        const auto [x, y] = stack.back();
+        std::array<int, 4> options;
+        auto count = 0;
+        for (auto d = 0; d < 4; ++d) {
+            const auto nx = x + dx[d];
+            const auto ny = y + dy[d];
+            if (nx > 0 && ny > 0 && nx < side - 1 && ny < side - 1 && maze[ny][nx] == '#') options[count++] = d;
+        }
+        if (count == 0) {
+            stack.pop_back();
+            continue;
+        }
+        const auto d = options[rng() % count];
+        maze[y + dy[d] / 2][x + dx[d] / 2] = '.';
+        maze[y + dy[d]][x + dx[d]] = '.';
+        stack.push_back({ x + dx[d], y + dy[d] });
+    }
+    return maze;
+}
+
+struct Position {
+    std::size_t x;
+    std::size_t y;
+    int32_t steps;
+};
+
+int64_t bfsSet(MAP const& map) {
+    std::array<int, 4> x_dir = { -1, 0, 0, 1 };
+    std::array<int, 4> y_dir = { 0, -1, 1, 0 };
+    std::set<std::tuple<std::size_t, std::size_t>> visited;
+    std::queue<Position> q;
+    q.push({ 1, 1, 0 });
+    visited.emplace(1, 1);
+    int64_t checksum = 0;
+    while (!q.empty()) {
+        const auto move = q.front();
+        q.pop();
+        checksum += move.steps;
+        for (int i = 0; i < 4; ++i) {
+            const auto x = move.x + x_dir[i];
+            const auto y = move.y + y_dir[i];
+            if (x >= map.size() || y >= map[x].size() || map[x][y] == '#') continue;
+            if (!visited.emplace(x, y).second) continue;
+            q.push({ x, y, move.steps + 1 });
+        }
+    }
+    return checksum;
+}
+
+int64_t bfsGrid(gridbfs::Grid const& grid) {
+    int64_t checksum = 0;
+    gridbfs::bfs(grid, grid.index(1, 1), [](char c) { return c != gridbfs::WALL; },
+        [&](uint32_t, uint32_t, int32_t distance) {
+            checksum += distance;
+            return false;
+        });
+    return checksum;
+}
+
+template <typename F>
+void measure(const char* name, int64_t cells, F fun) {
+    auto start = std::chrono::steady_clock::now();
+    const auto checksum = fun();
+    auto end = std::chrono::steady_clock::now();
+    const auto seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ": " << seconds * 1000 << "ms, " << cells / seconds / 1e6
+              << " Mcells/s (checksum " << checksum << ")\n";
+}
+}
+
+int main(int argc, char** argv)
+{
+    const auto side = argc > 1 ? std::stoi(argv[1]) : 4096;
+    const auto maze = generateMaze(side | 1, 2019);
+    const auto grid = gridbfs::Grid::fromLines(maze);
+    const auto cells = int64_t{ side } * side;
+
+    measure("std::set", cells, [&] { return bfsSet(maze); });
+    measure("gridbfs ", cells, [&] { return bfsGrid(grid); });
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#include "../common/grid_file.hpp"
+
+// Loading a large maze file: the per-character fstream loop the days used to have against the
+// memory-mapped gridfile loader. Both sides touch every cell once (a checksum) so the lazily
+// mapped pages are really read. The file is written first, so both runs see a warm page cache.
+// Build: g++ -std=c++20 -O2 bench/grid_load.cpp
+// Run:   ./a.out [side=10000] [file=/tmp/grid_load.txt]
+
+namespace {
+
+template <typename F>
+double measure(F fun) {
+    auto start = std::chrono::steady_clock::now();
+    fun();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+std::vector<std::vector<char>> loadWithStream(std::string const& path) {
+    std::vector<std::vector<char>> res;
+    char ch;
+    bool insertNewLine = false;
+    std::fstream fs(path, std::fstream::in);
+    res.push_back({});
+    while (fs.get(ch)) {
+        if (insertNewLine) {
+            res.push_back({});
+            insertNewLine = false;
+        }
+        res.back().push_back(ch);
+        if (ch == '\n') insertNewLine = true;
+    }
+    return res;
+}
+
+template <typename Rows>
+uint64_t checksum(Rows const& rows) {
+    uint64_t sum = 0;
+    for (auto const& row : rows)
+        for (const auto c : row) sum += c == '#';
+    return sum;
+}
+}
+
+int main(int argc, char** argv)
+{
+    const auto side = argc > 1 ? std::stoi(argv[1]) : 10000;
+    const std::string path = argc > 2 ? argv[2] : "/tmp/grid_load.txt";
+    {
+        std::mt19937 rng(2019);
+        std::ofstream out(path);
+        std::string line(side, '.');
+        for (auto y = 0; y < side; ++y) {
+            for (auto& c : line) c = rng() % 3 == 0 ? '#' : '.';
+            out << line << '\n';
+        }
+    }
+    const auto megabytes = static_cast<double>(side) * (side + 1) / (1 << 20);
+    std::cout << side << 'x' << side << " grid, " << megabytes << " MB\n";
+
+    uint64_t streamSum = 0, mappedSum = 0;
+    std::size_t rows = 0;
+    bool rectangular = false;
+    const auto streamSeconds = measure([&] { streamSum = checksum(loadWithStream(path)); });
+    const auto mappedSeconds = measure([&] {
+        const auto grid = gridfile::load(path);
+        rows = grid.size();
+        rectangular = grid.rectangular();
+        mappedSum = checksum(grid);
+    });
+    std::cout << "fstream: " << streamSeconds * 1000 << "ms, " << megabytes / streamSeconds << " MB/s\n";
+    std::cout << "mmap   : " << mappedSeconds * 1000 << "ms, " << megabytes / mappedSeconds << " MB/s, " << rows
+              << " rows" << (rectangular ? ", rectangular" : ", ragged") << '\n';
+    std::cout << (streamSum == mappedSum ? "checksums match\n" : "CHECKSUM MISMATCH\n");
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstdint>
+
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "../common/maze_gen.hpp"
+
+// Size sweep for the path-finding days: generates vaults and donuts (common/maze_gen.hpp), runs
+// every solver variant of the day binaries on them as separate processes and writes one CSV row
+// per run with wall time, peak RSS (wait4 rusage) and the states the solver reports as expanded.
+// The day20 variants all cut recursion at the same depth (nodes^2 over the portal tiles), but their
+// states differ in kind: (level, cell) for bfs / bidirectional, (level, portal tile) for dijkstra.
+// Build: g++ -std=c++20 -O2 bench/maze_sweep.cpp -o maze_sweep
+//        g++ -std=c++20 -O2 -pthread day18/main.cpp -o day18 && g++ -std=c++20 -O2 day20/main.cpp -o day20
+// Run:   ./maze_sweep ./day18 ./day20 [out.csv=maze_sweep.csv] [max side=641]
+
+extern char** environ;
+
+namespace {
+
+struct Run {
+    std::string output;
+    double seconds{ 0 };
+    long peakRssKb{ 0 };
+    int status{ -1 };
+};
+
+Run execute(std::vector<std::string> const& args) {
+    Run run;
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0) return run;
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, pipeFds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, pipeFds[0]);
+
+    std::vector<char*> argv;
+    for (auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+    argv.push_back(nullptr);
+
+    const auto start = std::chrono::steady_clock::now();
+    pid_t pid;
+    const auto spawned = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ) == 0;
+    posix_spawn_file_actions_destroy(&actions);
+    close(pipeFds[1]);
+    if (spawned) {
+        char buffer[4096];
+        for (ssize_t n; (n = read(pipeFds[0], buffer, sizeof(buffer))) > 0;)
+            run.output.append(buffer, n);
+        rusage usage{};
+        wait4(pid, &run.status, 0, &usage);
+        run.peakRssKb = usage.ru_maxrss;
+    }
+    close(pipeFds[0]);
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return run;
+}
+
+void write(std::string const& path, mazegen::Lines const& lines) {
+    std::ofstream out(path);
+    for (auto& line : lines) out << line << '\n';
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        std::cout << "usage: maze_sweep <day18 binary> <day20 binary> [out.csv] [max side]\n";
+        return -1;
+    }
+    const std::string day18 = argv[1];
+    const std::string day20 = argv[2];
+    const std::string csvPath = argc > 3 ? argv[3] : "maze_sweep.csv";
+    const auto maxSide = argc > 4 ? std::stoi(argv[4]) : 641;
+    const std::string input = "/tmp/maze_sweep_input.txt";
+
+    std::ofstream csv(csvPath);
+    csv << "day,variant,layout,side,param,answer,states,seconds,peak_rss_kb\n";
+    const auto record = [&](std::string const& day, std::string const& variant, std::string const& layout,
+                            int side, int param, std::vector<std::string> const& command) {
+        const auto run = execute(command);
+        std::istringstream parsed(run.output);
+        std::string answer = "-", states = "-";
+        parsed >> answer >> states;
+        if (run.status != 0) answer = "failed";
+        csv << day << ',' << variant << ',' << layout << ',' << side << ',' << param << ',' << answer << ','
+            << states << ',' << run.seconds << ',' << run.peakRssKb << '\n';
+        std::cout << day << ' ' << variant << ' ' << layout << " side " << side << ": " << answer << " in "
+                  << run.seconds * 1000 << "ms, " << states << " states, " << run.peakRssKb << "kB\n";
+    };
+
+    for (auto side = 41; side <= maxSide; side = side * 2 - 1) {
+        for (const auto layout : { "single", "split" }) {
+            write(input, mazegen::vault(side, 26, 0.5, std::string(layout) == "split", 2019));
+            for (const auto variant : { "dijkstra", "memo", "parallel" })
+                record("18", std::string("keygraph-") + variant, layout, side, 26, { day18, input, "solve", variant });
+        }
+    }
+
+    for (auto side = 41; side <= 4 * maxSide; side = side * 2 - 1) {
+        const auto pairs = std::min(side / 4, 400);
+        write(input, mazegen::donut(side, pairs, 2019));
+        for (const auto variant : { "bfs", "bidirectional", "dijkstra", "bfs-recursive", "bidirectional-recursive", "dijkstra-recursive" })
+            record("20", variant, "donut", side, pairs, { day20, input, variant });
+    }
+    unlink(input.c_str());
+    return 0;
+}
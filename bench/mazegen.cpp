@@ -0,0 +1,29 @@
+#include <iostream>
+#include <string>
+
+#include "../common/maze_gen.hpp"
+
+// Prints a generated puzzle input, e.g.
+//   ./mazegen vault 81 26 0.5 split > vault.txt      (side, keys, door density, split|single, [seed])
+//   ./mazegen donut 121 30 > donut.txt                (side, portal pairs, [seed])
+// Build: g++ -std=c++20 -O2 bench/mazegen.cpp -o mazegen
+
+int main(int argc, char** argv)
+{
+    const std::string kind = argc > 1 ? argv[1] : "";
+    if (kind == "vault" && argc >= 6) {
+        const auto seed = argc > 6 ? std::stoul(argv[6]) : 2019;
+        for (auto& line : mazegen::vault(std::stoi(argv[2]), std::stoi(argv[3]), std::stod(argv[4]), std::string(argv[5]) == "split", seed))
+            std::cout << line << '\n';
+        return 0;
+    }
+    if (kind == "donut" && argc >= 4) {
+        const auto seed = argc > 4 ? std::stoul(argv[4]) : 2019;
+        for (auto& line : mazegen::donut(std::stoi(argv[2]), std::stoi(argv[3]), seed))
+            std::cout << line << '\n';
+        return 0;
+    }
+    std::cout << "usage: mazegen vault <side> <keys> <door density> <split|single> [seed]\n"
+              << "       mazegen donut <side> <portal pairs> [seed]\n";
+    return -1;
+}
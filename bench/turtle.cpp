@@ -0,0 +1,75 @@
+#include <vector>
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <cstdint>
+
+#include "../common/turtle.hpp"
+
+// Compares the old nested switch (day11 style) with the turtle lookup tables.
+// Build: g++ -std=c++20 -O2 bench/turtle.cpp
+
+namespace {
+
+enum class Direction { UP, DOWN, LEFT, RIGHT };
+
+struct Walker {
+    int x{ 0 };
+    int y{ 0 };
+    Direction d{ Direction::UP };
+};
+
+void stepSwitch(Walker& w, int turn) {
+    switch (w.d) {
+    case Direction::UP:
+        if (turn == 0) { w.x -= 1; w.d = Direction::LEFT; }
+        else { w.x += 1; w.d = Direction::RIGHT; }
+        break;
+    case Direction::DOWN:
+        if (turn == 0) { w.x += 1; w.d = Direction::RIGHT; }
+        else { w.x -= 1; w.d = Direction::LEFT; }
+        break;
+    case Direction::LEFT:
+        if (turn == 0) { w.y += 1; w.d = Direction::DOWN; }
+        else { w.y -= 1; w.d = Direction::UP; }
+        break;
+    case Direction::RIGHT:
+        if (turn == 0) { w.y -= 1; w.d = Direction::UP; }
+        else { w.y += 1; w.d = Direction::DOWN; }
+        break;
+    }
+}
+
+template <typename F>
+void measure(const char* name, F fun) {
+    auto start = std::chrono::steady_clock::now();
+    const auto checksum = fun();
+    auto end = std::chrono::steady_clock::now();
+    std::cout << name << ": " << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+              << "us (checksum " << checksum << ")\n";
+}
+}
+
+int main()
+{
+    constexpr auto STEPS = 50'000'000;
+    std::vector<uint8_t> turns(STEPS);
+    std::mt19937 rng(2019);
+    for (auto& t : turns) t = rng() & 1;
+
+    measure("switch", [&] {
+        Walker w;
+        for (auto t : turns) stepSwitch(w, t);
+        return int64_t{ w.x } * 31 + w.y;
+    });
+
+    measure("table ", [&] {
+        turtle::State s;
+        for (auto t : turns) {
+            s.rotate(2 * t - 1);
+            s.step();
+        }
+        return int64_t{ s.x } * 31 + s.y;
+    });
+    return 0;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// Lock-free counterpart of FlatHashMap for parallel searches: packed 64-bit states mapped to the
+// best distance seen so far. Slots are claimed with a CAS on the key and distances only ever go
+// down through a CAS loop, so any number of threads may call relax() at the same time.
+// The table does not grow on its own: call reserve() between parallel phases (single-threaded)
+// with an upper bound of the states the next phase can add. ~0 is reserved as the empty marker.
+class ConcurrentMinMap {
+public:
+    static constexpr uint64_t EMPTY = ~uint64_t{ 0 };
+    static constexpr int32_t NONE = -1;
+
+    explicit ConcurrentMinMap(std::size_t expected = 1024) { allocate(capacityFor(expected)); }
+
+    // lowers the stored distance of `key` to `distance`; true when this call improved it
+    bool relax(uint64_t key, int32_t distance) {
+        for (auto i = slot(key);; i = (i + 1) & mask) {
+            auto current = keys[i].load(std::memory_order_acquire);
+            if (current == EMPTY) {
+                if (keys[i].compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                    count.fetch_add(1, std::memory_order_relaxed);
+                    current = key;
+                }
+            }
+            if (current != key) continue;
+            auto stored = values[i].load(std::memory_order_relaxed);
+            while (stored == NONE || distance < stored) {
+                if (values[i].compare_exchange_weak(stored, distance, std::memory_order_relaxed)) return true;
+            }
+            return false;
+        }
+    }
+
+    int32_t get(uint64_t key) const {
+        for (auto i = slot(key);; i = (i + 1) & mask) {
+            const auto current = keys[i].load(std::memory_order_acquire);
+            if (current == key) return values[i].load(std::memory_order_relaxed);
+            if (current == EMPTY) return NONE;
+        }
+    }
+
+    std::size_t size() const { return count.load(std::memory_order_relaxed); }
+
+    // not thread-safe: makes room for `extra` more keys at <= 50% load
+    void reserve(std::size_t extra) {
+        const auto needed = capacityFor(size() + extra);
+        if (needed <= capacity) return;
+        auto oldKeys = std::move(keys);
+        auto oldValues = std::move(values);
+        const auto oldCapacity = capacity;
+        allocate(needed);
+        for (auto i = 0u; i < oldCapacity; ++i) {
+            const auto key = oldKeys[i].load(std::memory_order_relaxed);
+            if (key != EMPTY) relax(key, oldValues[i].load(std::memory_order_relaxed));
+        }
+    }
+
+private:
+    static std::size_t capacityFor(std::size_t entries) {
+        std::size_t result = 16;
+        while (result < entries * 2) result *= 2;
+        return result;
+    }
+
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 31;
+        x *= 0x7fb5d329728ea185ull;
+        x ^= x >> 27;
+        x *= 0x81dadef4bc2dd44dull;
+        return x ^ (x >> 33);
+    }
+
+    std::size_t slot(uint64_t key) const { return mix(key) & mask; }
+
+    void allocate(std::size_t slots) {
+        capacity = slots;
+        mask = slots - 1;
+        keys = std::make_unique<std::atomic<uint64_t>[]>(slots);
+        values = std::make_unique<std::atomic<int32_t>[]>(slots);
+        for (auto i = 0u; i < slots; ++i) {
+            keys[i].store(EMPTY, std::memory_order_relaxed);
+            values[i].store(NONE, std::memory_order_relaxed);
+        }
+        count.store(0, std::memory_order_relaxed);
+    }
+
+    std::unique_ptr<std::atomic<uint64_t>[]> keys;
+    std::unique_ptr<std::atomic<int32_t>[]> values;
+    std::size_t capacity{ 0 };
+    std::size_t mask{ 0 };
+    std::atomic<std::size_t> count{ 0 };
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+// Open-addressing hash map for packed 64-bit search states (linear probing, power-of-two
+// capacity). Keys and values live in two flat arrays, so a lookup touches one or two cache
+// lines instead of chasing tree or bucket nodes. ~0 is reserved as the empty marker.
+template <typename Value>
+class FlatHashMap {
+public:
+    static constexpr uint64_t EMPTY = ~uint64_t{ 0 };
+
+    explicit FlatHashMap(std::size_t expected = 1024) {
+        std::size_t capacity = 16;
+        while (capacity < expected * 2) capacity *= 2;
+        keys.assign(capacity, EMPTY);
+        values.resize(capacity);
+    }
+
+    Value* find(uint64_t key) {
+        for (auto i = slot(key);; i = (i + 1) & mask()) {
+            if (keys[i] == key) return &values[i];
+            if (keys[i] == EMPTY) return nullptr;
+        }
+    }
+
+    // inserts `value` when the key is new, otherwise leaves the stored value untouched
+    std::pair<Value*, bool> tryEmplace(uint64_t key, Value value) {
+        if ((count + 1) * 2 > keys.size()) grow();
+        for (auto i = slot(key);; i = (i + 1) & mask()) {
+            if (keys[i] == key) return { &values[i], false };
+            if (keys[i] == EMPTY) {
+                keys[i] = key;
+                values[i] = value;
+                ++count;
+                return { &values[i], true };
+            }
+        }
+    }
+
+    std::size_t size() const { return count; }
+
+private:
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 31;
+        x *= 0x7fb5d329728ea185ull;
+        x ^= x >> 27;
+        x *= 0x81dadef4bc2dd44dull;
+        return x ^ (x >> 33);
+    }
+
+    std::size_t mask() const { return keys.size() - 1; }
+    std::size_t slot(uint64_t key) const { return mix(key) & mask(); }
+
+    void grow() {
+        FlatHashMap bigger(keys.size());
+        for (auto i = 0u; i < keys.size(); ++i)
+            if (keys[i] != EMPTY) bigger.tryEmplace(keys[i], values[i]);
+        *this = std::move(bigger);
+    }
+
+    std::vector<uint64_t> keys;
+    std::vector<Value> values;
+    std::size_t count{ 0 };
+};
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+// Building blocks for breadth-first searches over character mazes (day15, day18, day20, ...).
+// The maze is one padded row-major byte array, so a cell is a single 32-bit index and a move
+// is "index + offset[dir]"; the padding ring of walls removes every bounds check from the
+// inner loop. Visited state is one bit per (level, cell) and the queue is a ring buffer of
+// packed indices, so a search allocates a handful of flat arrays instead of tree nodes.
+namespace gridbfs {
+
+    constexpr char WALL = '#';
+
+    struct Grid {
+        int width{ 0 };     // padded width, i.e. maze width + 2
+        int height{ 0 };    // padded height
+        std::vector<char> cells;
+        // indexed like turtle::Dir: UP, RIGHT, DOWN, LEFT
+        std::array<int32_t, 4> offsets{};
+
+        Grid() = default;
+
+        Grid(int mazeWidth, int mazeHeight, char fill = WALL)
+            : width(mazeWidth + 2), height(mazeHeight + 2),
+              cells(static_cast<std::size_t>(width) * height, WALL),
+              offsets{ -width, 1, width, -1 } {
+            for (auto y = 0; y < mazeHeight; ++y)
+                for (auto x = 0; x < mazeWidth; ++x)
+                    cells[index(x, y)] = fill;
+        }
+
+        // rows may be ragged and may keep their trailing '\n'; missing cells become walls
+        template <typename Lines>
+        static Grid fromLines(Lines const& lines, char pad = WALL) {
+            int mazeWidth = 0;
+            for (auto const& line : lines)
+                mazeWidth = std::max(mazeWidth, static_cast<int>(lineLength(line)));
+            Grid grid(mazeWidth, static_cast<int>(lines.size()), pad);
+            auto y = 0;
+            for (auto const& line : lines) {
+                for (auto x = 0u; x < lineLength(line); ++x)
+                    grid.cells[grid.index(x, y)] = line[x];
+                ++y;
+            }
+            return grid;
+        }
+
+        // (x, y) are maze coordinates without the padding
+        uint32_t index(int x, int y) const { return static_cast<uint32_t>((y + 1) * width + x + 1); }
+        int x(uint32_t cell) const { return static_cast<int>(cell % width) - 1; }
+        int y(uint32_t cell) const { return static_cast<int>(cell / width) - 1; }
+        uint32_t size() const { return static_cast<uint32_t>(cells.size()); }
+
+        char operator[](uint32_t cell) const { return cells[cell]; }
+        char& operator[](uint32_t cell) { return cells[cell]; }
+
+        uint32_t find(char c) const {
+            for (auto i = 0u; i < cells.size(); ++i)
+                if (cells[i] == c) return i;
+            return size();
+        }
+
+    private:
+        template <typename Line>
+        static std::size_t lineLength(Line const& line) {
+            auto length = line.size();
+            while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) --length;
+            return length;
+        }
+    };
+
+    // one bit per (level, cell); levels are allocated the first time they are touched
+    class Visited {
+    public:
+        explicit Visited(uint32_t cellsPerLevel) : words((cellsPerLevel + 63) / 64) {}
+
+        bool test(uint32_t level, uint32_t cell) const {
+            return level < levels.size() && (levels[level][cell >> 6] >> (cell & 63)) & 1;
+        }
+
+        // returns true when the bit was clear before
+        bool testAndSet(uint32_t level, uint32_t cell) {
+            if (level >= levels.size()) levels.resize(level + 1);
+            auto& bits = levels[level];
+            if (bits.empty()) bits.assign(words, 0);
+            const auto bit = uint64_t{ 1 } << (cell & 63);
+            if (bits[cell >> 6] & bit) return false;
+            bits[cell >> 6] |= bit;
+            return true;
+        }
+
+        void clear() {
+            for (auto& bits : levels) bits.assign(bits.size(), 0);
+        }
+
+    private:
+        std::size_t words;
+        std::vector<std::vector<uint64_t>> levels;
+    };
+
+    // FIFO over a power-of-two ring that doubles when full
+    template <typename T = uint32_t>
+    class RingQueue {
+    public:
+        explicit RingQueue(std::size_t expected = 1024) {
+            std::size_t capacity = 16;
+            while (capacity < expected) capacity *= 2;
+            items.resize(capacity);
+        }
+
+        void push(T value) {
+            if (count == items.size()) grow();
+            items[(head + count) & (items.size() - 1)] = value;
+            ++count;
+        }
+
+        T pop() {
+            const auto value = items[head];
+            head = (head + 1) & (items.size() - 1);
+            --count;
+            return value;
+        }
+
+        bool empty() const { return count == 0; }
+        std::size_t size() const { return count; }
+        void clear() { head = count = 0; }
+
+    private:
+        void grow() {
+            std::vector<T> bigger(items.size() * 2);
+            for (auto i = 0u; i < count; ++i)
+                bigger[i] = items[(head + i) & (items.size() - 1)];
+            items = std::move(bigger);
+            head = 0;
+        }
+
+        std::vector<T> items;
+        std::size_t head{ 0 };
+        std::size_t count{ 0 };
+    };
+
+    // Single-level BFS from `start`. Entering a cell requires open(grid[cell]). Every reached cell
+    // is reported once as visit(cell, parent, distance) in order of distance (the start comes with
+    // itself as parent); returning true from visit stops the search. The distance is not stored per
+    // cell - the queue is drained one layer at a time instead.
+    template <typename Open, typename Visit>
+    void bfs(Grid const& grid, uint32_t start, Open open, Visit visit) {
+        Visited visited(grid.size());
+        RingQueue<uint32_t> q;
+        visited.testAndSet(0, start);
+        if (visit(start, start, 0)) return;
+        q.push(start);
+        for (int32_t distance = 1; !q.empty(); ++distance) {
+            for (auto layer = q.size(); layer > 0; --layer) {
+                const auto cell = q.pop();
+                for (const auto offset : grid.offsets) {
+                    const auto next = cell + offset;
+                    if (!open(grid[next]) || !visited.testAndSet(0, next)) continue;
+                    if (visit(next, cell, distance)) return;
+                    q.push(next);
+                }
+            }
+        }
+    }
+
+    // Extra one-step moves on top of the grid: from a portal cell to its partner, changing the level
+    // by levelChange (day20: +1 through the inner ring, -1 through the outer one). Levels never go
+    // below 0 and, when maxLevel >= 0, never above maxLevel.
+    struct Portals {
+        static constexpr uint32_t NONE = ~uint32_t{ 0 };
+        std::vector<uint32_t> partner;
+        std::vector<int8_t> levelChange;
+        bool recursive{ false };
+        int32_t maxLevel{ -1 };
+
+        explicit Portals(uint32_t cells = 0) : partner(cells, NONE), levelChange(cells, 0) {}
+
+        void link(uint32_t from, uint32_t to, int levelDelta) {
+            partner[from] = to;
+            levelChange[from] = static_cast<int8_t>(levelDelta);
+        }
+    };
+
+    // distance per (level, cell), -1 when unseen; levels are allocated on first touch
+    class Distances {
+    public:
+        explicit Distances(uint32_t cellsPerLevel) : cells(cellsPerLevel) {}
+
+        int32_t get(uint32_t level, uint32_t cell) const {
+            return level < levels.size() && !levels[level].empty() ? levels[level][cell] : -1;
+        }
+
+        void set(uint32_t level, uint32_t cell, int32_t distance) {
+            if (level >= levels.size()) levels.resize(level + 1);
+            if (levels[level].empty()) levels[level].assign(cells, -1);
+            levels[level][cell] = distance;
+        }
+
+    private:
+        uint32_t cells;
+        std::vector<std::vector<int32_t>> levels;
+    };
+
+    struct SearchResult {
+        int32_t distance{ -1 };
+        uint64_t expanded{ 0 };     // states taken off a queue
+    };
+
+    namespace detail {
+        inline uint64_t pack(uint32_t level, uint32_t cell) { return uint64_t{ level } << 32 | cell; }
+
+        // Moves out of (level, cell); reverse = true walks the edges backwards, which for a portal
+        // means arriving from the partner with the partner's level change undone.
+        template <typename Open, typename Emit>
+        void neighbours(Grid const& grid, Open const& open, Portals const* portals, bool reverse,
+                        uint32_t level, uint32_t cell, Emit emit) {
+            for (const auto offset : grid.offsets)
+                if (open(grid[cell + offset])) emit(level, cell + offset);
+            if (!portals || portals->partner.empty() || portals->partner[cell] == Portals::NONE) return;
+            const auto other = portals->partner[cell];
+            auto next = static_cast<int64_t>(level);
+            if (portals->recursive)
+                next += reverse ? -portals->levelChange[other] : portals->levelChange[cell];
+            if (next < 0 || (portals->maxLevel >= 0 && next > portals->maxLevel)) return;
+            emit(static_cast<uint32_t>(next), other);
+        }
+    }
+
+    // One-sided layered BFS from (level 0, start) to (level 0, goal).
+    template <typename Open>
+    SearchResult shortestPath(Grid const& grid, Open open, uint32_t start, uint32_t goal, Portals const* portals = nullptr) {
+        SearchResult result;
+        if (start == goal) return { 0, 0 };
+        Visited visited(grid.size());
+        RingQueue<uint64_t> q;
+        visited.testAndSet(0, start);
+        q.push(detail::pack(0, start));
+        for (int32_t distance = 1; !q.empty(); ++distance) {
+            for (auto layer = q.size(); layer > 0; --layer) {
+                const auto state = q.pop();
+                ++result.expanded;
+                auto found = false;
+                detail::neighbours(grid, open, portals, false, static_cast<uint32_t>(state >> 32), static_cast<uint32_t>(state),
+                    [&](uint32_t level, uint32_t cell) {
+                        if (!visited.testAndSet(level, cell)) return;
+                        found = found || (level == 0 && cell == goal);
+                        q.push(detail::pack(level, cell));
+                    });
+                if (found) {
+                    result.distance = distance;
+                    return result;
+                }
+            }
+        }
+        return result;
+    }
+
+    // Bidirectional layered BFS: always grows the smaller frontier by one full layer, the backward
+    // side walking reversed edges. Once a layer touches the other side, every path no longer than
+    // the two radii combined has been seen, so the best meeting found in that layer is optimal.
+    template <typename Open>
+    SearchResult shortestPathBidirectional(Grid const& grid, Open open, uint32_t start, uint32_t goal, Portals const* portals = nullptr) {
+        SearchResult result;
+        if (start == goal) return { 0, 0 };
+        std::array<Distances, 2> distances = { Distances(grid.size()), Distances(grid.size()) };
+        std::array<RingQueue<uint64_t>, 2> queues;
+        distances[0].set(0, start, 0);
+        distances[1].set(0, goal, 0);
+        queues[0].push(detail::pack(0, start));
+        queues[1].push(detail::pack(0, goal));
+        while (!queues[0].empty() && !queues[1].empty()) {
+            const auto side = queues[0].size() <= queues[1].size() ? 0 : 1;
+            auto& q = queues[side];
+            auto& mine = distances[side];
+            auto const& theirs = distances[1 - side];
+            auto best = -1;
+            for (auto layer = q.size(); layer > 0; --layer) {
+                const auto state = q.pop();
+                ++result.expanded;
+                const auto level = static_cast<uint32_t>(state >> 32);
+                const auto cell = static_cast<uint32_t>(state);
+                const auto distance = mine.get(level, cell) + 1;
+                detail::neighbours(grid, open, portals, side == 1, level, cell, [&](uint32_t nextLevel, uint32_t next) {
+                    if (mine.get(nextLevel, next) != -1) return;
+                    mine.set(nextLevel, next, distance);
+                    if (const auto other = theirs.get(nextLevel, next); other != -1)
+                        if (best == -1 || distance + other < best) best = distance + other;
+                    q.push(detail::pack(nextLevel, next));
+                });
+            }
+            if (best != -1) {
+                result.distance = best;
+                return result;
+            }
+        }
+        return result;
+    }
+}
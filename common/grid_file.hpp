@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <utility>
+#include <cstring>
+#include <cstddef>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Puzzle grids straight from a memory-mapped file: line breaks are found with memchr and every
+// row is a string_view into the mapping (without its '\n' / "\r\n"), so loading costs the page
+// faults of the file plus one vector of row views - no per-character stream reads, no per-row
+// allocations. A GridFile reads like the old std::vector<std::vector<char>> inputs (size(),
+// [y][x], range-for over rows) and can be handed to gridbfs::Grid::fromLines as it is.
+// An unreadable file loads as an empty grid, the same as the fstream loops it replaces.
+namespace gridfile {
+
+    class MappedFile {
+    public:
+        MappedFile() = default;
+
+        explicit MappedFile(std::string const& path) {
+            const auto fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) return;
+            struct stat info {};
+            if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+                const auto size = static_cast<std::size_t>(info.st_size);
+                auto* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapped != MAP_FAILED) {
+                    ::madvise(mapped, size, MADV_SEQUENTIAL);
+                    bytes = static_cast<const char*>(mapped);
+                    length = size;
+                }
+            }
+            ::close(fd);
+        }
+
+        MappedFile(MappedFile&& other) noexcept
+            : bytes(std::exchange(other.bytes, nullptr)), length(std::exchange(other.length, 0)) {}
+
+        MappedFile& operator=(MappedFile&& other) noexcept {
+            std::swap(bytes, other.bytes);
+            std::swap(length, other.length);
+            return *this;
+        }
+
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile const&) = delete;
+
+        ~MappedFile() {
+            if (bytes) ::munmap(const_cast<char*>(bytes), length);
+        }
+
+        const char* data() const { return bytes; }
+        std::size_t size() const { return length; }
+
+    private:
+        const char* bytes{ nullptr };
+        std::size_t length{ 0 };
+    };
+
+    class GridFile {
+    public:
+        explicit GridFile(std::string const& path) : file(path) {
+            const auto* begin = file.data();
+            const auto* end = begin + file.size();
+            for (auto* line = begin; line < end;) {
+                const auto* newline = static_cast<const char*>(std::memchr(line, '\n', end - line));
+                const auto* next = newline ? newline + 1 : end;
+                auto length = static_cast<std::size_t>((newline ? newline : end) - line);
+                if (length > 0 && line[length - 1] == '\r') --length;
+                rows.emplace_back(line, length);
+                line = next;
+            }
+            for (const auto row : rows) {
+                maxWidth = std::max(maxWidth, row.size());
+                minWidth = std::min(minWidth, row.size());
+            }
+            if (rows.empty()) minWidth = 0;
+        }
+
+        std::size_t size() const { return rows.size(); }
+        bool empty() const { return rows.empty(); }
+        std::string_view operator[](std::size_t y) const { return rows[y]; }
+        auto begin() const { return rows.begin(); }
+        auto end() const { return rows.end(); }
+
+        // width of the longest row; equal to every row's width when the grid is rectangular
+        std::size_t width() const { return maxWidth; }
+        bool rectangular() const { return minWidth == maxWidth; }
+
+        // a mutable copy for the days that edit their map
+        template <typename Rows = std::vector<std::vector<char>>>
+        Rows copy() const {
+            Rows result;
+            result.reserve(rows.size());
+            for (const auto row : rows) result.emplace_back(row.begin(), row.end());
+            return result;
+        }
+
+    private:
+        MappedFile file;
+        std::vector<std::string_view> rows;
+        std::size_t maxWidth{ 0 };
+        std::size_t minWidth{ std::string_view::npos };
+    };
+
+    inline GridFile load(std::string const& path) { return GridFile(path); }
+}
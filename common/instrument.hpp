@@ -0,0 +1,218 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+#include <cstdlib>
+
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+// Scoped timers for hot loops: INSTRUMENT_SCOPE("label"[, items]) at the top of a block times it
+// with steady_clock (ns) and files the sample under its label. At exit every label is summarised
+// on stderr - count, total, min / p50 / p99 / max and items per second when the scopes report how
+// much they processed. Environment switches:
+//  - INSTRUMENT_PERF=1   also samples cycles, instructions and cache misses per scope through a
+//                        perf_event_open group per thread (silently off where perf is not allowed);
+//  - INSTRUMENT_JSON=path writes the summary as JSON to path instead of printing it.
+// Every sample is kept for the percentiles, so scopes belong around phases and solver runs, not
+// around single loop iterations.
+namespace instrument {
+
+    struct Counters {
+        uint64_t cycles{ 0 };
+        uint64_t instructions{ 0 };
+        uint64_t cacheMisses{ 0 };
+    };
+
+    namespace detail {
+        inline bool perfRequested() {
+            static const bool requested = std::getenv("INSTRUMENT_PERF") != nullptr;
+            return requested;
+        }
+
+        // cycles lead the group, so one read() returns all three in order
+        class PerfGroup {
+        public:
+            PerfGroup() {
+                if (!perfRequested()) return;
+                for (const auto config : { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES }) {
+                    perf_event_attr attr{};
+                    attr.size = sizeof(attr);
+                    attr.type = PERF_TYPE_HARDWARE;
+                    attr.config = config;
+                    attr.disabled = fds[0] == -1;
+                    attr.exclude_kernel = 1;
+                    attr.exclude_hv = 1;
+                    attr.read_format = PERF_FORMAT_GROUP;
+                    const auto fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, fds[0], 0));
+                    if (fd == -1) {
+                        close();
+                        return;
+                    }
+                    fds[count++] = fd;
+                }
+                ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+            ~PerfGroup() { close(); }
+            PerfGroup(PerfGroup const&) = delete;
+            PerfGroup& operator=(PerfGroup const&) = delete;
+
+            bool available() const { return count == 3; }
+
+            bool read(Counters& out) const {
+                if (!available()) return false;
+                struct { uint64_t nr; uint64_t values[3]; } group{};
+                if (::read(fds[0], &group, sizeof(group)) != static_cast<ssize_t>(sizeof(group))) return false;
+                out = { group.values[0], group.values[1], group.values[2] };
+                return true;
+            }
+
+        private:
+            void close() {
+                for (auto i = 0; i < count; ++i) ::close(fds[i]);
+                count = 0;
+                fds[0] = -1;
+            }
+            int fds[3]{ -1, -1, -1 };
+            int count{ 0 };
+        };
+
+        inline PerfGroup& perfGroup() {
+            thread_local PerfGroup group;
+            return group;
+        }
+    }
+
+    struct LabelStats {
+        std::vector<uint64_t> nanoseconds;
+        uint64_t items{ 0 };
+        Counters counters;
+        bool hasCounters{ false };
+    };
+
+    class Registry {
+    public:
+        ~Registry() {
+            if (stats.empty()) return;
+            if (const auto* path = std::getenv("INSTRUMENT_JSON")) {
+                std::ofstream out(path);
+                writeJson(out);
+            }
+            else report(std::cerr);
+        }
+
+        void add(std::string const& label, uint64_t ns, uint64_t items, Counters const* counters) {
+            std::lock_guard lock(mutex);
+            auto& s = stats[label];
+            s.nanoseconds.push_back(ns);
+            s.items += items;
+            if (counters) {
+                s.hasCounters = true;
+                s.counters.cycles += counters->cycles;
+                s.counters.instructions += counters->instructions;
+                s.counters.cacheMisses += counters->cacheMisses;
+            }
+        }
+
+        void report(std::ostream& out) {
+            std::lock_guard lock(mutex);
+            out << "-- instrument summary (ms)\n";
+            for (auto& [label, s] : stats) {
+                const auto summary = summarise(s);
+                out << std::fixed << std::setprecision(3) << label << ": " << summary.count << "x, total "
+                    << summary.total / 1e6 << ", min " << summary.min / 1e6 << ", p50 " << summary.p50 / 1e6
+                    << ", p99 " << summary.p99 / 1e6 << ", max " << summary.max / 1e6;
+                if (s.items) out << ", " << std::setprecision(1) << s.items / (summary.total / 1e9) / 1e6 << " M items/s";
+                if (s.hasCounters) {
+                    out << ", " << s.counters.cycles << " cycles, IPC " << std::setprecision(2)
+                        << static_cast<double>(s.counters.instructions) / std::max<uint64_t>(1, s.counters.cycles)
+                        << ", " << s.counters.cacheMisses << " cache misses";
+                }
+                out << '\n';
+            }
+            out << std::defaultfloat;
+        }
+
+        void writeJson(std::ostream& out) {
+            std::lock_guard lock(mutex);
+            out << "{";
+            auto first = true;
+            for (auto& [label, s] : stats) {
+                const auto summary = summarise(s);
+                out << (first ? "" : ",") << "\n  \"" << label << "\": { \"count\": " << summary.count
+                    << ", \"total_ns\": " << summary.total << ", \"min_ns\": " << summary.min << ", \"p50_ns\": "
+                    << summary.p50 << ", \"p99_ns\": " << summary.p99 << ", \"max_ns\": " << summary.max
+                    << ", \"items\": " << s.items;
+                if (s.hasCounters) {
+                    out << ", \"cycles\": " << s.counters.cycles << ", \"instructions\": " << s.counters.instructions
+                        << ", \"cache_misses\": " << s.counters.cacheMisses;
+                }
+                out << " }";
+                first = false;
+            }
+            out << "\n}\n";
+        }
+
+    private:
+        struct Summary { std::size_t count; uint64_t total, min, p50, p99, max; };
+
+        static Summary summarise(LabelStats& s) {
+            auto& ns = s.nanoseconds;
+            std::sort(ns.begin(), ns.end());
+            uint64_t total = 0;
+            for (const auto t : ns) total += t;
+            const auto at = [&](std::size_t percent) { return ns[(ns.size() - 1) * percent / 100]; };
+            return { ns.size(), total, ns.front(), at(50), at(99), ns.back() };
+        }
+
+        std::mutex mutex;
+        std::map<std::string, LabelStats> stats;
+    };
+
+    inline Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(const char* label, uint64_t items = 0) : label(label), items(items) {
+            registry();     // constructed before any timer finishes, destroyed after the last one
+            counted = detail::perfGroup().read(before);
+            start = std::chrono::steady_clock::now();
+        }
+
+        ~ScopedTimer() {
+            const auto end = std::chrono::steady_clock::now();
+            Counters after;
+            const auto withCounters = counted && detail::perfGroup().read(after);
+            Counters delta{ after.cycles - before.cycles, after.instructions - before.instructions, after.cacheMisses - before.cacheMisses };
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+            registry().add(label, static_cast<uint64_t>(ns), items, withCounters ? &delta : nullptr);
+        }
+
+        ScopedTimer(ScopedTimer const&) = delete;
+        ScopedTimer& operator=(ScopedTimer const&) = delete;
+
+    private:
+        const char* label;
+        uint64_t items;
+        Counters before;
+        bool counted{ false };
+        std::chrono::steady_clock::time_point start;
+    };
+}
+
+#define INSTRUMENT_CONCAT_(a, b) a##b
+#define INSTRUMENT_CONCAT(a, b) INSTRUMENT_CONCAT_(a, b)
+#define INSTRUMENT_SCOPE(...) ::instrument::ScopedTimer INSTRUMENT_CONCAT(instrumentScope, __LINE__)(__VA_ARGS__)
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <array>
+#include <random>
+#include <numeric>
+#include <algorithm>
+#include <cstdint>
+
+// Generators for puzzle-shaped inputs, printed in exactly the format of the real ones:
+//  - vault (day18): four quadrant mazes around a centre '@' (or four '@' when split), keys a..z
+//    and doors that never make the vault unsolvable;
+//  - donut (day20): a ring maze with two-letter portal labels on its outer and inner edges.
+// Every maze is carved as a spanning tree (randomized DFS), which is the shape the key-graph
+// solver of day18 relies on.
+namespace mazegen {
+
+    using Lines = std::vector<std::string>;
+
+    namespace detail {
+        // carves a spanning tree over the cells (x, y) with x, y both even inside [0, w) x [0, h)
+        // for which inside(x, y) holds; (ox, oy) is added to every coordinate when writing to out
+        template <typename Inside>
+        void carve(Lines& out, int ox, int oy, int w, int h, int rootX, int rootY, Inside inside, std::mt19937& rng) {
+            const std::array<int, 4> dx = { 0, 2, 0, -2 };
+            const std::array<int, 4> dy = { -2, 0, 2, 0 };
+            std::vector<std::pair<int, int>> stack = { { rootX, rootY } };
+            out[oy + rootY][ox + rootX] = '.';
+            while (!stack.empty()) {
+                const auto [x, y] = stack.back();
+                std::array<int, 4> options;
+                auto count = 0;
+                for (auto d = 0; d < 4; ++d) {
+                    const auto nx = x + dx[d];
+                    const auto ny = y + dy[d];
+                    if (nx < 0 || ny < 0 || nx >= w || ny >= h || !inside(nx, ny)) continue;
+                    if (out[oy + ny][ox + nx] == '#') options[count++] = d;
+                }
+                if (count == 0) {
+                    stack.pop_back();
+                    continue;
+                }
+                const auto d = options[rng() % count];
+                out[oy + y + dy[d] / 2][ox + x + dx[d] / 2] = '.';
+                out[oy + y + dy[d]][ox + x + dx[d]] = '.';
+                stack.push_back({ x + dx[d], y + dy[d] });
+            }
+        }
+    }
+
+    // side is rounded to 4k + 5 so that the four quadrant mazes meet in a 3x3 centre. Keys land on
+    // random open tiles; each key gets a door with probability doorDensity. Keys are collected in a
+    // hidden random order and a door is only put where everything behind it comes later in that
+    // order, so the vault always stays solvable.
+    inline Lines vault(int side, int keys, double doorDensity, bool split, uint32_t seed) {
+        std::mt19937 rng(seed);
+        const auto q = std::max(1, (side - 3) / 2) | 1;     // quadrant interior, odd
+        const auto n = 2 * q + 3;
+        const auto c = n / 2;
+        Lines out(n, std::string(n, '#'));
+
+        // quadrant interiors start at 1 and at c + 1; every tree is rooted at a corner of the centre
+        const std::array<std::pair<int, int>, 4> origins = { { { 1, 1 }, { c + 1, 1 }, { 1, c + 1 }, { c + 1, c + 1 } } };
+        for (const auto& [ox, oy] : origins) {
+            const auto rootX = ox == 1 ? q - 1 : 0;
+            const auto rootY = oy == 1 ? q - 1 : 0;
+            detail::carve(out, ox, oy, q, q, rootX, rootY, [](int, int) { return true; }, rng);
+        }
+        for (auto y = c - 1; y <= c + 1; ++y)
+            for (auto x = c - 1; x <= c + 1; ++x)
+                out[y][x] = split && (x == c || y == c) ? '#' : '.';
+        if (split) {
+            for (const auto y : { c - 1, c + 1 })
+                for (const auto x : { c - 1, c + 1 }) out[y][x] = '@';
+        }
+        else out[c][c] = '@';
+
+        // parent links of the walk from the centre, to know what lies behind each tile
+        const auto index = [n](int x, int y) { return y * n + x; };
+        std::vector<int> parent(n * n, -1), order;
+        std::vector<std::pair<int, int>> queue;
+        for (auto y = c - 1; y <= c + 1; ++y)
+            for (auto x = c - 1; x <= c + 1; ++x)
+                if (out[y][x] != '#') { queue.push_back({ x, y }); parent[index(x, y)] = index(x, y); }
+        for (auto head = 0u; head < queue.size(); ++head) {
+            const auto [x, y] = queue[head];
+            order.push_back(index(x, y));
+            for (const auto& [dx, dy] : { std::pair{ 0, -1 }, std::pair{ 1, 0 }, std::pair{ 0, 1 }, std::pair{ -1, 0 } }) {
+                const auto nx = x + dx;
+                const auto ny = y + dy;
+                if (out[ny][nx] == '#' || parent[index(nx, ny)] != -1) continue;
+                parent[index(nx, ny)] = index(x, y);
+                queue.push_back({ nx, ny });
+            }
+        }
+
+        std::vector<int> free;
+        for (const auto cell : order)
+            if (std::abs(cell % n - c) > 1 || std::abs(cell / n - c) > 1) free.push_back(cell);
+        std::shuffle(free.begin(), free.end(), rng);
+        keys = std::clamp(keys, 0, std::min(26, static_cast<int>(free.size())));
+
+        // rank[k]: position of key k in the hidden collection order
+        std::vector<int> rank(keys);
+        std::iota(rank.begin(), rank.end(), 0);
+        std::shuffle(rank.begin(), rank.end(), rng);
+        std::vector<int> keyAt(n * n, -1);
+        for (auto k = 0; k < keys; ++k) {
+            keyAt[free[k]] = k;
+            out[free[k] / n][free[k] % n] = static_cast<char>('a' + k);
+        }
+
+        // lowest rank of any key in the subtree of each tile, children before parents
+        std::vector<int> minRank(n * n, keys);
+        for (auto it = order.rbegin(); it != order.rend(); ++it) {
+            if (keyAt[*it] != -1) minRank[*it] = std::min(minRank[*it], rank[keyAt[*it]]);
+            if (parent[*it] != *it) minRank[parent[*it]] = std::min(minRank[parent[*it]], minRank[*it]);
+        }
+
+        std::bernoulli_distribution hasDoor(doorDensity);
+        for (auto k = 0; k < keys; ++k) {
+            if (!hasDoor(rng)) continue;
+            std::vector<int> spots;
+            for (auto i = static_cast<std::size_t>(keys); i < free.size(); ++i) {
+                const auto cell = free[i];
+                if (out[cell / n][cell % n] == '.' && minRank[cell] < keys && minRank[cell] > rank[k]) spots.push_back(cell);
+            }
+            if (spots.empty()) continue;
+            const auto cell = spots[rng() % spots.size()];
+            out[cell / n][cell % n] = static_cast<char>('A' + k);
+        }
+        return out;
+    }
+
+    // Ring maze of side x side tiles (rounded to odd) around a hole, framed by two rows/columns of
+    // labels. AA and ZZ sit on the outer edge, every other pair joins an outer and an inner tile.
+    // Fewer pairs are placed when the edges run out of room.
+    inline Lines donut(int side, int pairs, uint32_t seed) {
+        std::mt19937 rng(seed);
+        const auto m = std::max(side, 15) | 1;
+        auto t = std::max(3, m / 4) | 1;                     // ring thickness, odd
+        while (m - 2 * t < 7) t -= 2;
+        const auto n = m + 4;
+        Lines out(n, std::string(n, ' '));
+        const auto inHole = [&](int x, int y) { return x >= t && x <= m - 1 - t && y >= t && y <= m - 1 - t; };
+        for (auto y = 0; y < m; ++y)
+            for (auto x = 0; x < m; ++x)
+                if (!inHole(x, y)) out[y + 2][x + 2] = '#';
+        detail::carve(out, 2, 2, m, m, 0, 0, [&](int x, int y) { return !inHole(x, y); }, rng);
+
+        // candidate tiles (maze coordinates) and the direction the label extends in
+        struct Spot { int x, y, dx, dy; };
+        std::vector<Spot> outer, inner;
+        for (auto i = 2; i <= m - 3; i += 2) {
+            outer.push_back({ i, 0, 0, -1 });
+            outer.push_back({ i, m - 1, 0, 1 });
+            outer.push_back({ 0, i, -1, 0 });
+            outer.push_back({ m - 1, i, 1, 0 });
+        }
+        for (auto i = t + 3; i <= m - 4 - t; i += 2) {
+            inner.push_back({ i, t - 1, 0, 1 });
+            inner.push_back({ i, m - t, 0, -1 });
+            inner.push_back({ t - 1, i, 1, 0 });
+            inner.push_back({ m - t, i, -1, 0 });
+        }
+        std::shuffle(outer.begin(), outer.end(), rng);
+        std::shuffle(inner.begin(), inner.end(), rng);
+
+        const auto label = [&](Spot s, std::string const& name) {
+            // names read left to right / top to bottom, whichever side of the tile they are on
+            const auto first = s.dx + s.dy < 0 ? 2 : 1;
+            out[s.y + 2 + s.dy * first][s.x + 2 + s.dx * first] = name[0];
+            out[s.y + 2 + s.dy * (3 - first)][s.x + 2 + s.dx * (3 - first)] = name[1];
+        };
+        label(outer[0], "AA");
+        label(outer[1], "ZZ");
+        pairs = std::min({ pairs, static_cast<int>(outer.size()) - 2, static_cast<int>(inner.size()), 26 * 26 - 2 });
+        for (auto i = 0, id = 0; i < pairs; ++id) {
+            const std::string name = { static_cast<char>('A' + id / 26 % 26), static_cast<char>('A' + id % 26) };
+            if (name == "AA" || name == "ZZ") continue;
+            label(outer[2 + i], name);
+            label(inner[i], name);
+            ++i;
+        }
+        return out;
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Direction/turn tables shared by every grid walker (day11 painter, day15 repair droid, ...).
+// Directions are numbered clockwise starting from UP, so turning is plain arithmetic mod 4
+// and moving is a table lookup - no branches on the per-step path.
+namespace turtle {
+
+    using Dir = uint8_t;
+
+    constexpr Dir UP = 0;
+    constexpr Dir RIGHT = 1;
+    constexpr Dir DOWN = 2;
+    constexpr Dir LEFT = 3;
+
+    constexpr int TURN_LEFT = -1;
+    constexpr int TURN_RIGHT = 1;
+
+    // screen coordinates: x grows to the right, y grows downwards
+    constexpr std::array<int, 4> DX = { 0, 1, 0, -1 };
+    constexpr std::array<int, 4> DY = { -1, 0, 1, 0 };
+
+    constexpr Dir turn(Dir d, int t) {
+        return static_cast<Dir>((d + t) & 3);
+    }
+
+    constexpr Dir opposite(Dir d) {
+        return static_cast<Dir>((d + 2) & 3);
+    }
+
+    struct State {
+        int x{ 0 };
+        int y{ 0 };
+        Dir dir{ UP };
+
+        constexpr void rotate(int t) {
+            dir = turn(dir, t);
+        }
+
+        constexpr void step(int n = 1) {
+            x += DX[dir] * n;
+            y += DY[dir] * n;
+        }
+    };
+
+    static_assert(turn(UP, TURN_LEFT) == LEFT);
+    static_assert(turn(LEFT, TURN_RIGHT) == UP);
+    static_assert(opposite(RIGHT) == LEFT);
+}
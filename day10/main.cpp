@@ -14,42 +14,22 @@
 #include <cassert>
 #include <queue>
 #include <list>
-#include <fstream>
 #include <thread>
 #include <chrono>
 #include <unordered_set>
 #include <set>
 
+#include "../common/grid_file.hpp"
 
 namespace {
 
-using DataType = std::vector<std::vector<char>>;
-const auto loadData = [](auto path){
-    DataType res;
-    {
-        char ch;
-        bool insertNewLine = false;
-        std::fstream fs(path, std::fstream::in);
-        res.push_back({});
-        while (fs.get(ch)) {
-            if (insertNewLine) {
-                res.push_back({});
-                insertNewLine = false;
-            }
-            res.back().push_back(ch);
-            if (ch == '\n') {
-                insertNewLine = true;
-            }
-        }
-        fs.close();
-    }
-    return res;
-};
+using DataType = gridfile::GridFile;
 
 const auto printData = [](auto& data) {
     for (auto& line: data) {
         for (auto ch: line)
             std::cout << ch;
+        std::cout << '\n';
     }
 };
 
@@ -58,7 +38,7 @@ auto firstPuzzleX = 0;
 auto firstPuzzleY = 0;
 
 
-const auto getVisibleAsteroidsCount = [](int ii, int jj, DataType& map) {
+const auto getVisibleAsteroidsCount = [](int ii, int jj, DataType const& map) {
     std::set<float> angles;
     for (auto i = 0; i < static_cast<int>(map.size()); ++i) {
         for (auto j = 0; j < static_cast<int>(map[i].size()); ++j) {
@@ -105,9 +85,9 @@ const auto getAngle = [](auto xx, auto yy) {
     }
     return deg;
 };
-const auto calculateAngles = [](int ii, int jj, DataType& input) {
+const auto calculateAngles = [](int ii, int jj, DataType const& input) {
     std::map<float, std::vector<Asteroid>> angles;
-    auto map = input;
+    auto const& map = input;
 
     for (auto i = 0; i < static_cast<int>(map.size()); ++i) {
         for (auto j = 0; j < static_cast<int>(map[i].size()); ++j) {
@@ -134,7 +114,11 @@ int main(int argc, char** argv)
     }
 
     const std::string path = argv[1];
-    auto input = loadData(path);
+    const auto input = gridfile::load(path);
+    if (!input.rectangular()) {
+        std::cout << "asteroid map is not rectangular\n";
+        return -1;
+    }
     auto sum = 0u;
     auto ii = 0;
     auto jj = 0;
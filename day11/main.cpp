@@ -14,6 +14,9 @@
 #include <stack>
 #include <cassert>
 #include <queue>
+#include <list>
+
+#include "../common/turtle.hpp"
 
 namespace {
 
@@ -328,20 +331,10 @@ namespace {
 
     constexpr auto TURN_LEFT = 0;
     constexpr auto TURN_RIGHT = 1;
-    enum class Direction {
-        UP,
-        DOWN,
-        LEFT,
-        RIGHT
-    };
 
-const auto dumpDirection = [](Direction d) {
-    switch (d) {
-    case Direction::UP: return "UP";
-    case Direction::DOWN: return "DOWN";
-    case Direction::LEFT: return "LEFT";
-    case Direction::RIGHT: return "RIGHT";
-    }
+const auto dumpDirection = [](turtle::Dir d) {
+    constexpr std::array<const char*, 4> names = { "UP", "RIGHT", "DOWN", "LEFT" };
+    return names[d];
 };
 
 struct Position {
@@ -374,7 +367,7 @@ const auto getMinMaxXY = [](auto& map) {
 
 struct PaintingRobot {
     PaintingRobot(IntCodeComputer c) : pc(c),
-        current_direction(Direction::UP),
+        current_direction(turtle::UP),
         current_position({ 0,0 }),
         current_colour(WHITE)
     {
@@ -430,61 +423,16 @@ struct PaintingRobot {
     }
 
 private:
+    // x is the image row and y the image column, hence the swapped DX/DY
     Position updateCurrentDirectionGetNewPosition(int newDirection) {
-        Position newPos{ current_position.x, current_position.y};
-        switch (current_direction) {
-        case Direction::UP: {
-            if (newDirection == TURN_LEFT) {
-                newPos.y -= 1;
-                current_direction = Direction::LEFT;
-            }
-            else if (newDirection == TURN_RIGHT) {
-                newPos.y += 1;
-                current_direction = Direction::RIGHT;
-            }
-            break;
-        }
-        case Direction::DOWN: {
-            if (newDirection == TURN_LEFT) {
-                newPos.y += 1;
-                current_direction = Direction::RIGHT;
-            }
-            else if (newDirection == TURN_RIGHT) {
-                newPos.y -= 1;
-                current_direction = Direction::LEFT;
-            }
-            break;
-        }
-        case Direction::LEFT: {
-            if (newDirection == TURN_LEFT) {
-                newPos.x += 1;
-                current_direction = Direction::DOWN;
-            }
-            else if (newDirection == TURN_RIGHT) {
-                newPos.x -= 1;
-                current_direction = Direction::UP;
-            }
-            break;
-        }
-        case Direction::RIGHT: {
-            if (newDirection == TURN_LEFT) {
-                newPos.x -= 1;
-                current_direction = Direction::UP;
-            }
-            else if (newDirection == TURN_RIGHT) {
-                newPos.x += 1;
-                current_direction = Direction::DOWN;
-            }
-            break;
-        }
-        }
-
-        return newPos;
+        // VM answers 0 (TURN_LEFT) or 1 (TURN_RIGHT), map it onto -1/+1 without branching
+        current_direction = turtle::turn(current_direction, 2 * newDirection - 1);
+        return { current_position.x + turtle::DY[current_direction], current_position.y + turtle::DX[current_direction] };
     }
 
 private:
     IntCodeComputer pc;
-    Direction current_direction;
+    turtle::Dir current_direction;
     Position current_position;
     int current_colour;
 
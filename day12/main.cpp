@@ -4,7 +4,6 @@
 #include <algorithm>
 #include <string>
 #include <map>
-#include <map>
 #include <array>
 #include <cmath>
 #include <tuple>
@@ -12,6 +11,15 @@
 #include <optional>
 #include <unordered_set>
 #include <numeric>
+#include <random>
+#include <chrono>
+#include <new>
+#include <thread>
+#include <cstdint>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 namespace {
 struct Pos {
@@ -19,21 +27,8 @@ struct Pos {
     int y;
     int z;
 };
-struct Velocity {
-    int x{ 0 };
-    int y{ 0 };
-    int z{ 0 };
-};
-struct Moon {
-    Pos p;
-    Velocity v;
-    bool operator==(Moon const& o) const {
-        return o.p.x == p.x && o.p.y == p.y && o.p.z == p.z
-            && o.v.x == v.x && o.v.y == v.y && o.v.z == v.z;
-    }
-};
 
-std::vector<Moon> input = {
+std::vector<Pos> input = {
     {15, -2, -6},
     {-5, -4, -11},
     {0, -6, 0},
@@ -41,106 +36,221 @@ std::vector<Moon> input = {
 
 };
 
-const auto print = [](std::vector<Moon>& input) {
-    for (auto& moon : input) {
-        std::cout << "Pos:(" << moon.p.x << ", " << moon.p.y << ", " << moon.p.z << ")"
-            << "\tVel:(" << moon.v.x << ", " << moon.v.y << ", " << moon.v.z << ")\n";
-    }
-};
+// 32-byte aligned storage, so the AVX2 kernels read whole aligned vectors from the front
+template <typename T>
+struct AlignedAllocator {
+    using value_type = T;
+    static constexpr std::align_val_t ALIGNMENT{ 32 };
 
-const auto getKineticEnery = [](Moon const& m) {
-    return std::abs(m.v.x) + std::abs(m.v.y) + std::abs(m.v.z);
-};
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(AlignedAllocator<U> const&) {}
 
-const auto getPotentialEnery = [](Moon const& m) {
-    return std::abs(m.p.x) + std::abs(m.p.y) + std::abs(m.p.z);
-};
+    T* allocate(std::size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), ALIGNMENT)); }
+    void deallocate(T* p, std::size_t) { ::operator delete(p, ALIGNMENT); }
 
-const auto getMoonTotalEnergy = [](Moon const& m) {
-    return getKineticEnery(m) * getPotentialEnery(m);
+    template <typename U>
+    bool operator==(AlignedAllocator<U> const&) const { return true; }
 };
 
-const auto applyGravity= [](std::vector<Moon>& input) {
-    std::vector<Moon> updated_values{ {}, {}, {},{} };
-    for (auto i = 0u; i < input.size(); ++i) {
-        for (auto j = 0u; j < input.size(); ++j) {
-            if (j == i) continue;
+using Values = std::vector<int32_t, AlignedAllocator<int32_t>>;
 
-            auto& first = input[i];
-            auto& second = input[j];
+// The bodies as structure of arrays: one position and one velocity array per axis. Axes never
+// interact, so a step is three independent 1D updates.
+struct Axis {
+    Values position;
+    Values velocity;
 
-            if (first.p.x != second.p.x) {
-                updated_values[i].v.x += first.p.x < second.p.x ? 1 : -1;
-            }
+    bool operator==(Axis const&) const = default;
+};
 
-            if (first.p.y != second.p.y) {
-                updated_values[i].v.y += first.p.y < second.p.y ? 1 : -1;
-            }
+struct Bodies {
+    std::array<Axis, 3> axes;
 
-            if (first.p.z != second.p.z) {
-                updated_values[i].v.z += first.p.z < second.p.z ? 1 : -1;
-            }
-        }
+    std::size_t size() const { return axes[0].position.size(); }
+};
+
+const auto makeBodies = [](std::vector<Pos> const& positions) {
+    Bodies bodies;
+    for (auto& axis : bodies.axes) {
+        axis.position.resize(positions.size());
+        axis.velocity.assign(positions.size(), 0);
+    }
+    for (auto i = 0u; i < positions.size(); ++i) {
+        bodies.axes[0].position[i] = positions[i].x;
+        bodies.axes[1].position[i] = positions[i].y;
+        bodies.axes[2].position[i] = positions[i].z;
     }
+    return bodies;
+};
 
-    for (auto i = 0u; i < input.size(); ++i) {
-        input[i].v.x += updated_values[i].v.x;
-        input[i].v.y += updated_values[i].v.y;
-        input[i].v.z += updated_values[i].v.z;
+const auto print = [](Bodies const& bodies) {
+    auto const& [x, y, z] = bodies.axes;
+    for (auto i = 0u; i < bodies.size(); ++i) {
+        std::cout << "Pos:(" << x.position[i] << ", " << y.position[i] << ", " << z.position[i] << ")"
+            << "\tVel:(" << x.velocity[i] << ", " << y.velocity[i] << ", " << z.velocity[i] << ")\n";
     }
 };
 
-const auto applyVelocity = [](std::vector<Moon>& input) {
-    for (auto& moon : input) {
-        moon.p.x += moon.v.x;
-        moon.p.y += moon.v.y;
-        moon.p.z += moon.v.z;
+const auto getTotalEnergy = [](Bodies const& bodies) {
+    int64_t sum = 0;
+    for (auto i = 0u; i < bodies.size(); ++i) {
+        int64_t potential = 0;
+        int64_t kinetic = 0;
+        for (auto const& axis : bodies.axes) {
+            potential += std::abs(axis.position[i]);
+            kinetic += std::abs(axis.velocity[i]);
+        }
+        sum += potential * kinetic;
     }
+    return sum;
 };
 
-const auto getMoon = [](auto & input, char axis) -> Moon {
-    if (axis == 'x') {
-        return { input[0].p.x, input[1].p.x, input[2].p.x, input[3].p.x };
+// Gravity along one axis: body i is pulled by sign(p[j] - p[i]) from every j (itself adds 0).
+// Branchless: the two comparisons give 0 / 1 each; with AVX2 eight bodies are compared at once,
+// where a true comparison is -1 and so gets subtracted / added the other way round.
+inline void applyGravity(Axis& axis) {
+    const auto n = axis.position.size();
+    const auto* p = axis.position.data();
+    auto* v = axis.velocity.data();
+    for (auto i = 0u; i < n; ++i) {
+        const auto pi = p[i];
+        int32_t dv = 0;
+        std::size_t j = 0;
+#ifdef __AVX2__
+        const auto mine = _mm256_set1_epi32(pi);
+        auto pulls = _mm256_setzero_si256();
+        for (; j + 8 <= n; j += 8) {
+            const auto others = _mm256_load_si256(reinterpret_cast<__m256i const*>(p + j));
+            pulls = _mm256_sub_epi32(pulls, _mm256_cmpgt_epi32(others, mine));
+            pulls = _mm256_add_epi32(pulls, _mm256_cmpgt_epi32(mine, others));
+        }
+        alignas(32) std::array<int32_t, 8> lanes;
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.data()), pulls);
+        for (const auto lane : lanes) dv += lane;
+#endif
+        for (; j < n; ++j)
+            dv += (p[j] > pi) - (p[j] < pi);
+        v[i] += dv;
     }
-    else if (axis == 'y') {
-        return { input[0].p.y, input[1].p.y, input[2].p.y, input[3].p.y };
+}
+
+inline void applyVelocity(Axis& axis) {
+    const auto n = axis.position.size();
+    auto* p = axis.position.data();
+    const auto* v = axis.velocity.data();
+    for (auto i = 0u; i < n; ++i)
+        p[i] += v[i];
+}
+
+inline void step(Bodies& bodies) {
+    for (auto& axis : bodies.axes) {
+        applyGravity(axis);
+        applyVelocity(axis);
     }
-    else {
-        return { input[0].p.z, input[1].p.z, input[2].p.z, input[3].p.z };
+}
+
+// Steps until one axis is back in its initial state. A step can be undone (positions from the
+// velocities, then velocities from the positions), so the orbit of the initial state is a pure
+// cycle: its first repeated state is the initial one, which is all that has to be kept. The axis
+// is copied into the worker, so every thread has its own small arrays to loop over; the usual
+// handful of moons gets a fixed-size copy the compiler can unroll completely.
+template <std::size_t N>
+uint64_t fixedAxisPeriod(Axis const& initial) {
+    std::array<int32_t, N> p0, v0;
+    std::copy_n(initial.position.begin(), N, p0.begin());
+    std::copy_n(initial.velocity.begin(), N, v0.begin());
+    auto p = p0;
+    auto v = v0;
+    uint64_t steps = 0;
+    do {
+        for (auto i = 0u; i < N; ++i) {
+            int32_t dv = 0;
+            for (auto j = 0u; j < N; ++j)
+                dv += (p[j] > p[i]) - (p[j] < p[i]);
+            v[i] += dv;
+        }
+        for (auto i = 0u; i < N; ++i)
+            p[i] += v[i];
+        ++steps;
+    } while (v != v0 || p != p0);
+    return steps;
+}
+
+const auto axisPeriod = [](Axis const& initial) -> uint64_t {
+    switch (initial.position.size()) {
+        case 2: return fixedAxisPeriod<2>(initial);
+        case 3: return fixedAxisPeriod<3>(initial);
+        case 4: return fixedAxisPeriod<4>(initial);
+        case 5: return fixedAxisPeriod<5>(initial);
     }
+    auto axis = initial;
+    uint64_t steps = 0;
+    do {
+        applyGravity(axis);
+        applyVelocity(axis);
+        ++steps;
+    } while (axis.velocity != initial.velocity || axis.position != initial.position);
+    return steps;
+};
+
+// axes never interact, so each one is searched on its own thread and the periods joined by lcm
+const auto systemPeriod = [](Bodies const& initial) {
+    std::array<uint64_t, 3> periods{};
+    std::vector<std::thread> workers;
+    for (auto a = 0u; a < 3; ++a)
+        workers.emplace_back([&, a] { periods[a] = axisPeriod(initial.axes[a]); });
+    for (auto& worker : workers) worker.join();
+    return std::pair(std::lcm(periods[0], std::lcm(periods[1], periods[2])), periods);
+};
+
+// random bodies in a cube, to time the step kernel on more than four moons
+const auto randomBodies = [](std::size_t count, uint32_t seed, int range = 1000) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> coordinate(-range, range);
+    std::vector<Pos> positions(count);
+    for (auto& p : positions) p = { coordinate(rng), coordinate(rng), coordinate(rng) };
+    return makeBodies(positions);
 };
 
 }
 
-int main() {
+int main(int argc, char** argv) {
 
-    int sum = 0;
-    const auto copy_input = input;
-    for (auto i = 0u; i < 1000; ++i) {
-        applyGravity(input);
-        applyVelocity(input);
+    // "bench [bodies] [steps]": throughput of the step kernel on random bodies
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        const auto count = argc > 2 ? std::stoull(argv[2]) : 10000ull;
+        const auto steps = argc > 3 ? std::stoull(argv[3]) : 100ull;
+        auto bodies = randomBodies(count, 2019);
+        const auto start = std::chrono::steady_clock::now();
+        for (auto i = 0ull; i < steps; ++i)
+            step(bodies);
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << count << " bodies, " << steps << " steps: " << seconds * 1000 << "ms, "
+                  << count * steps / seconds / 1e6 << " M body-steps/s, energy " << getTotalEnergy(bodies) << '\n';
+        return 0;
     }
-    for (auto& moon : input)
-        sum += getMoonTotalEnergy(moon);
-    std::cout << "First puzzle answer: " << sum << '\n';
-    input = copy_input;
-
-    uint64_t counter = 1;
-    Moon x({ input[0].p.x, input[1].p.x, input[2].p.x, input[3].p.x });
-    Moon y({ input[0].p.y, input[1].p.y, input[2].p.y, input[3].p.y });
-    Moon z({ input[0].p.z, input[1].p.z, input[2].p.z, input[3].p.z });
-    uint64_t x_counter = 0;
-    uint64_t y_counter = 0;
-    uint64_t z_counter = 0;
-    while (x_counter == 0 || y_counter == 0 || z_counter == 0) {
-        applyGravity(input);
-        applyVelocity(input);
-        counter++;
-        if (x_counter == 0 && x == getMoon(input, 'x')) x_counter = counter;
-        if (y_counter == 0 && y == getMoon(input, 'y')) y_counter = counter;
-        if (z_counter == 0 && z == getMoon(input, 'z')) z_counter = counter;
+    // "periods [bodies] [seed] [range]": the per-axis cycle search on random bodies
+    if (argc > 1 && std::string(argv[1]) == "periods") {
+        const auto count = argc > 2 ? std::stoull(argv[2]) : 4ull;
+        const auto seed = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 2019u;
+        const auto range = argc > 4 ? std::stoi(argv[4]) : 20;
+        const auto bodies = randomBodies(count, seed, range);
+        const auto start = std::chrono::steady_clock::now();
+        const auto [period, periods] = systemPeriod(bodies);
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const auto steps = periods[0] + periods[1] + periods[2];
+        std::cout << "axis periods " << periods[0] << ' ' << periods[1] << ' ' << periods[2] << ", period " << period
+                  << ", " << seconds * 1000 << "ms, " << steps / seconds / 1e6 << " M axis-steps/s\n";
+        return 0;
     }
 
-    std::cout << "Second puzzle answer: " << std::lcm(x_counter, std::lcm(y_counter, z_counter)) << '\n';
+    auto bodies = makeBodies(input);
+    for (auto i = 0u; i < 1000; ++i)
+        step(bodies);
+    std::cout << "First puzzle answer: " << getTotalEnergy(bodies) << '\n';
+
+    const auto [period, periods] = systemPeriod(makeBodies(input));
+    std::cout << "Second puzzle answer: " << period << '\n';
     return 0;
-}
\ No newline at end of file
+}
@@ -15,6 +15,10 @@
 #include <cassert>
 #include <queue>
 #include <thread>
+
+#include "../common/turtle.hpp"
+#include "../common/bitboard_bfs.hpp"
+
 namespace {
 
     enum class OpCodes {
@@ -35,6 +39,10 @@ namespace {
     constexpr auto WEST = 3;
     constexpr auto EAST = 4;
 
+    // movement commands understood by the droid, indexed by turtle direction and back
+    constexpr std::array<int, 4> COMMAND_FOR_DIR = { NORTH, EAST, SOUTH, WEST };
+    constexpr std::array<turtle::Dir, 5> DIR_FOR_COMMAND = { 0, turtle::UP, turtle::DOWN, turtle::LEFT, turtle::RIGHT };
+
     std::ostream& operator<<(std::ostream& s, OpCodes code) {
         switch (code) {
         case OpCodes::STOP:         s << "STOP"; break;
@@ -334,7 +342,6 @@ namespace {
             return false;
         }
     };
-    int64_t steps = 0;
     struct RepairRobot {
         RepairRobot(IntCodeComputer c) : pc(c)
         {
@@ -343,16 +350,22 @@ namespace {
 
         void explore() {
             addPoint(0, 0, 'S');
-            makeMove(NORTH, 0, -1);
-            makeMove(SOUTH, 0, 1);
-            makeMove(EAST, 1, 0);
-            makeMove(WEST, -1, 0);
+            exploreNeighbours(0, 0);
         }
 
-        void refillWithOxygen() {
-            refillWithOxygen(oxygen_point, 0);
+        // BFS from both the start and the oxygen system until the two waves meet
+        int shortestPathToOxygen() {
+            const auto [board, origin] = openBoard();
+            return bitboard::shortestPathBidirectional(board, -origin.x, -origin.y,
+                oxygen_point.x - origin.x, oxygen_point.y - origin.y);
         }
 
+        // oxygen spreads one cell per minute, i.e. the number of BFS levels from the oxygen system
+        int refillWithOxygen() {
+            const auto [board, origin] = openBoard();
+            return bitboard::bfs(board, oxygen_point.x - origin.x, oxygen_point.y - origin.y,
+                [](int, bitboard::Board const&) { return false; }).levels;
+        }
 
         void printMap() {
             auto [x, y, xs_size, ys_size] = getMapSize();
@@ -379,23 +392,13 @@ namespace {
         }
 
 private:
-    void refillWithOxygen(Point p, uint64_t depth) {
-        if (map.count({p.x, p.y}) == 0) return;
-        if (map[{p.x, p.y}] == '#') return;
-        if (filled_with_oxygen.count(p) > 0) return;
-
-        filled_with_oxygen.insert(p);
-        //798 is deduced basing on explored area; could be computed automatically, although
-        max_depth = std::max(max_depth, depth);
-        if (filled_with_oxygen.size() == 798) {
-            std::cout << "Second day puzzle: " << max_depth << '\n';
-            return;
-        }
-
-        refillWithOxygen({p.x, p.y -1}, depth+1);
-        refillWithOxygen({p.x, p.y +1}, depth+1);
-        refillWithOxygen({p.x+1, p.y}, depth+1);
-        refillWithOxygen({p.x-1, p.y}, depth+1);
+    // explored cells as a bitboard, shifted so that the top-left corner of the map is (0, 0)
+    std::pair<bitboard::Board, Point> openBoard() const {
+        auto [x, y, xs_size, ys_size] = getMapSize();
+        bitboard::Board board(xs_size, ys_size);
+        for (auto& e : map)
+            if (e.second != '#') board.set(e.first.x - x, e.first.y - y);
+        return { board, Point{ x, y } };
     }
 
     void makeMove(int direction, int x, int y) {
@@ -410,35 +413,29 @@ private:
         }
 
         addPoint(x, y, c);
-        ++steps;
         if (type == 2) {
-            std::cout << "First puzzle answer: " << steps << '\n';
             oxygen_point = {x,y};
         }
 
-        makeMove(NORTH, x, y -1);
-        makeMove(SOUTH, x, y + 1);
-        makeMove(EAST, x + 1, y);
-        makeMove(WEST, x - 1, y);
+        exploreNeighbours(x, y);
 
         if (pc.run(getOpositeDirection(direction)) != 1) std::cout << "ZONK\n";
-        --steps;
+    }
+
+    void exploreNeighbours(int x, int y) {
+        for (auto command : { NORTH, SOUTH, EAST, WEST }) {
+            const auto [nx, ny] = getNewPositions(command, x, y);
+            makeMove(command, nx, ny);
+        }
     }
 
     std::pair<int, int> getNewPositions (int direction, int x, int y) {
-        if (direction == NORTH) return {x, y - 1};
-        if (direction == SOUTH) return {x, y + 1};
-        if (direction == EAST) return {x + 1, y};
-        if (direction == WEST) return {x - 1, y};
-        return {};
+        const auto d = DIR_FOR_COMMAND[direction];
+        return {x + turtle::DX[d], y + turtle::DY[d]};
     }
+
     int getOpositeDirection(int direction) {
-        if (direction == NORTH) return SOUTH;
-        if (direction == SOUTH) return NORTH;
-        if (direction == EAST) return WEST;
-        if (direction == WEST) return EAST;
-        assert(false);
-        return 0;
+        return COMMAND_FOR_DIR[turtle::opposite(DIR_FOR_COMMAND[direction])];
     }
 
     std::pair<std::map<Point, char>::iterator, bool> addPoint(int x, int y, char c) {
@@ -462,8 +459,6 @@ private:
     IntCodeComputer pc;
     std::map<Point, char> map;
     Point oxygen_point;
-    std::set<Point> filled_with_oxygen;
-    uint64_t max_depth{0};
 };
 }
 
@@ -475,7 +470,8 @@ int main()
     IntCodeComputer pc(input);
     RepairRobot r(pc);
     r.explore();
-    r.refillWithOxygen();
+    std::cout << "First puzzle answer: " << r.shortestPathToOxygen() << '\n';
+    std::cout << "Second day puzzle: " << r.refillWithOxygen() << '\n';
     //r.printMap();
     std::cout << '\n';
 
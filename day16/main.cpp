@@ -17,23 +17,42 @@
 #include <array>
 #include <numeric>
 #include <chrono>
+#include <cstdint>
+#include <thread>
+#include <atomic>
+#include <barrier>
+#include <string_view>
+#include <limits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../common/instrument.hpp"
 
 namespace {
 
-template <typename F, typename... Args>
-auto measureTimeInSeconds(F fun, Args&&... args){
-    auto start = std::chrono::steady_clock::now();
-    fun(std::forward<Args>(args)...);
-    auto end = std::chrono::steady_clock::now();
-    std::cout << " elapsed: " << std::chrono::duration_cast<std::chrono::seconds>(end - start).count() << "s\n";
-}
+// The real signal is the input repeated many times; it is never built. Digits are read through
+// the index modulo the input length and only the part a kernel works on is copied out.
+struct RepeatedSignal {
+    std::string_view base;
+    uint64_t repeats{ 1 };
 
-const auto convertToVector = [](std::string input) {
-    std::vector<int> res;
-    for (auto ch : input) {
-        res.push_back(ch - '0');
+    uint64_t size() const { return base.size() * repeats; }
+    uint8_t operator[](uint64_t i) const { return static_cast<uint8_t>(base[i % base.size()] - '0'); }
+
+    std::vector<uint8_t> slice(uint64_t from, uint64_t to) const {
+        std::vector<uint8_t> res;
+        res.reserve(to - from);
+        // whole copies of the input after the first partial one
+        for (auto i = from; i < to;) {
+            const auto start = i % base.size();
+            const auto length = std::min<uint64_t>(base.size() - start, to - i);
+            for (auto j = start; j < start + length; ++j) res.push_back(static_cast<uint8_t>(base[j] - '0'));
+            i += length;
+        }
+        return res;
     }
-    return res;
 };
 
 inline auto extractLastDigit(int val) {
@@ -45,77 +64,248 @@ const auto print = [](auto const& v) {
     }
 };
 
-inline auto partial_sum(std::vector<int>& input,  std::size_t len,  std::size_t offset) {
-    int sum = 0;
-    std::size_t i = offset;
-    for (; i < offset + len && i < input.size(); i++)
-        sum += input[i];
-    return std::make_pair(sum, i - offset);
+// From offset n/2 on the pattern of position j is j zeros followed by nothing but ones, so a
+// phase over the tail is a running sum from the back, mod 10. The digits are bytes: 16 at a time
+// get their suffix sums inside the register (at most 16 * 9 + 9 < 256), the carry of the block
+// after them added and are reduced mod 10 by conditional subtraction.
+using Digits = std::vector<uint8_t>;
+
+#ifdef __SSE2__
+inline __m128i mod10(__m128i x) {
+    // x - k wraps around to something larger than x when x < k, so min keeps x exactly then
+    for (const auto k : { 80, 40, 20, 10 })
+        x = _mm_min_epu8(x, _mm_sub_epi8(x, _mm_set1_epi8(static_cast<char>(k))));
+    return x;
 }
+#endif
 
-int getValuesFromRange(std::vector<int>& input,  std::size_t iteration,  std::size_t offset) {
-    const int size = input.size();
-    int sum = 0;
-    int i = offset;
-    int j = 0;
-    bool flag = true;
-    do {
-        if (j % 4 == 0) {
-            const auto [s, ii] = partial_sum(input, iteration, i);
-            sum += s;
-            i += ii;
-            flag = i < size;
-        }
-        else if (j % 4 == 1) {
-            i += iteration;
-            flag = i < size;
+inline void suffixSumPhase(Digits& digits) {
+    auto i = digits.size();
+    uint8_t carry = 0;
+#ifdef __SSE2__
+    for (; i >= 16; ) {
+        i -= 16;
+        auto x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(digits.data() + i));
+        x = _mm_add_epi8(x, _mm_srli_si128(x, 1));
+        x = _mm_add_epi8(x, _mm_srli_si128(x, 2));
+        x = _mm_add_epi8(x, _mm_srli_si128(x, 4));
+        x = _mm_add_epi8(x, _mm_srli_si128(x, 8));
+        x = mod10(_mm_add_epi8(x, _mm_set1_epi8(static_cast<char>(carry))));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(digits.data() + i), x);
+        carry = digits[i];
+    }
+#endif
+    while (i > 0) {
+        --i;
+        carry += digits[i];
+        if (carry >= 10) carry -= 10;
+        digits[i] = carry;
+    }
+}
+
+// Any offset: the digits from the offset on, their prefix sums and the next phase, all allocated
+// once and reused. Output j (global position, pattern period k = j + 1) is the range sums
+// +[j, j+k) -[j+2k, j+3k) +[j+4k, j+5k) ..., each one lookup pair in the prefix sums, so a phase
+// costs n/k per digit - O(n log n) in total. Digits of one phase are independent, so the outputs
+// are handed out to the threads in chunks.
+struct PhaseBuffers {
+    Digits digits;
+    Digits next;
+    std::vector<int32_t> prefix;
+    std::size_t offset{ 0 };
+
+    PhaseBuffers(Digits tail, std::size_t offset)
+        : digits(std::move(tail)), next(digits.size()), prefix(digits.size() + 1), offset(offset) {}
+};
+
+// The threads of the prefix-sum phases, started once for the whole run: each phase the caller
+// publishes its work, releases the others through one barrier and meets them at a second one.
+class PhaseWorkers {
+public:
+    explicit PhaseWorkers(int threads) : roundStart(std::max(1, threads)), roundEnd(std::max(1, threads)) {
+        for (auto t = 1; t < threads; ++t) {
+            pool.emplace_back([this] {
+                for (;;) {
+                    roundStart.arrive_and_wait();
+                    if (!task) return;
+                    (*task)();
+                    roundEnd.arrive_and_wait();
+                }
+            });
         }
-        else if (j % 4 == 2){
-            const auto [s, ii] = partial_sum(input, iteration, i);
-            sum -= s;
-            i += ii;
-            flag = i < size;
+    }
+
+    ~PhaseWorkers() {
+        task = nullptr;
+        if (!pool.empty()) roundStart.arrive_and_wait();
+        for (auto& thread : pool) thread.join();
+    }
+
+    PhaseWorkers(PhaseWorkers const&) = delete;
+    PhaseWorkers& operator=(PhaseWorkers const&) = delete;
+
+    int size() const { return static_cast<int>(pool.size()) + 1; }
+
+    // runs work on every thread, the caller's included, and returns once all of them are done
+    void run(std::function<void()> const& work) {
+        if (pool.empty()) {
+            work();
+            return;
         }
-        else {
-            i += iteration;
-            flag = i < size;
+        task = &work;
+        roundStart.arrive_and_wait();
+        work();
+        roundEnd.arrive_and_wait();
+    }
+
+private:
+    std::vector<std::thread> pool;
+    std::barrier<> roundStart, roundEnd;
+    std::function<void()> const* task{ nullptr };
+};
+
+inline void prefixSumPhase(PhaseBuffers& buffers, PhaseWorkers& workers) {
+    const auto n = buffers.digits.size();
+    auto& prefix = buffers.prefix;
+    for (auto i = 0u; i < n; ++i)
+        prefix[i + 1] = prefix[i] + buffers.digits[i];
+
+    constexpr std::size_t CHUNK = 4096;
+    std::atomic<std::size_t> nextChunk{ 0 };
+    const std::function<void()> work = [&] {
+        for (std::size_t from; (from = nextChunk.fetch_add(CHUNK)) < n;) {
+            for (auto l = from; l < std::min(n, from + CHUNK); ++l) {
+                const auto k = buffers.offset + l + 1;
+                int32_t sum = 0;
+                for (auto start = l, sign = std::size_t{ 0 }; start < n; start += 2 * k, sign ^= 1) {
+                    const auto range = prefix[std::min(n, start + k)] - prefix[start];
+                    sum += sign ? -range : range;
+                }
+                buffers.next[l] = static_cast<uint8_t>(extractLastDigit(sum));
+            }
         }
-        ++j;
-    } while (flag);
+    };
+    // a phase that fits one chunk is not worth waking the other threads for
+    if (n <= CHUNK) work();
+    else workers.run(work);
+    std::swap(buffers.digits, buffers.next);
+}
 
-    return sum;
+// Second half again, without running the phases: after P phases digit i of the tail is
+// sum over m of C(P - 1 + m, m) * digit[i + m] (mod 10), the P-fold running sum. The binomials
+// mod 10 come from Lucas' theorem mod 2 and mod 5 joined by CRT, so only the requested digits
+// are computed, in O(n log n) whatever the number of phases.
+inline int binomialModPrime(uint64_t n, uint64_t k, int p) {
+    static constexpr std::array<std::array<int, 5>, 5> small = { {
+        { 1, 0, 0, 0, 0 }, { 1, 1, 0, 0, 0 }, { 1, 2, 1, 0, 0 }, { 1, 3, 3, 1, 0 }, { 1, 4, 6, 4, 1 } } };
+    auto result = 1;
+    for (; k > 0 && result != 0; n /= p, k /= p) {
+        const auto ni = n % p;
+        const auto ki = k % p;
+        if (ki > ni) return 0;
+        result = result * small[ni][ki] % p;
+    }
+    return result;
+}
+
+inline int binomialMod10(uint64_t n, uint64_t k) {
+    // x = 5 * (x mod 2) + 6 * (x mod 5) (mod 10)
+    return (5 * binomialModPrime(n, k, 2) + 6 * binomialModPrime(n, k, 5)) % 10;
 }
 
-const auto calculatePhase = [](std::vector<int>& input,  std::size_t offset) {
-    std::vector<int> new_input(input.size());
-    for (auto j = offset; j < input.size(); ++j) {
-        int sum = extractLastDigit(getValuesFromRange(input, j + 1, j));
-        new_input[j] = sum;
+template <typename Signal>
+inline Digits binomialDigits(Signal const& signal, uint64_t from, uint64_t phases, std::size_t count = 8) {
+    const auto length = signal.size() - from;
+    count = static_cast<std::size_t>(std::min<uint64_t>(count, length));
+    Digits result(count);
+    if (phases == 0) {
+        for (auto i = 0u; i < count; ++i) result[i] = signal[from + i];
+        return result;
     }
-    std::swap(input, new_input);
+    // one pass over the coefficients, straight from the signal: nothing of size n is stored
+    std::vector<uint64_t> sums(count);
+    for (uint64_t m = 0; m < length; ++m) {
+        const auto c = binomialMod10(phases - 1 + m, m);
+        if (c == 0) continue;
+        for (auto i = 0u; i < count && i + m < length; ++i)
+            sums[i] += c * signal[from + i + m];
+    }
+    for (auto i = 0u; i < count; ++i) result[i] = static_cast<uint8_t>(sums[i] % 10);
+    return result;
+}
+
+const auto firstDigits = [](Digits const& digits) {
+    return std::vector<int>{ digits.begin(), digits.begin() + std::min<std::size_t>(8, digits.size()) };
 };
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    // "auto" takes the suffix-sum kernel whenever the message lies in the second half and the
+    // prefix-sum kernel otherwise; "suffix" / "prefix" / "binomial" force one of them for part two
+    const std::string mode = argc > 1 ? argv[1] : "auto";
+    const auto threads = argc > 2 ? std::stoi(argv[2]) : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    // phases and repetitions of part two; "-" as the signal keeps the puzzle input
+    const auto phases = argc > 4 ? std::stoull(argv[4]) : 100ull;
+    const auto repeats = argc > 5 ? std::stoull(argv[5]) : 10000ull;
     std::string input = "59777373021222668798567802133413782890274127408951008331683345339720122013163879481781852674593848286028433137581106040070180511336025315315369547131580038526194150218831127263644386363628622199185841104247623145887820143701071873153011065972442452025467973447978624444986367369085768018787980626750934504101482547056919570684842729787289242525006400060674651940042434098846610282467529145541099887483212980780487291529289272553959088376601234595002785156490486989001949079476624795253075315137318482050376680864528864825100553140541159684922903401852101186028076448661695003394491692419964366860565639600430440581147085634507417621986668549233797848";
     //input = "12345678";
     //input = "03036732577212944063491565474664";
-    std::string ss;
-    for (auto i = 1; i <= 10000; ++i) {
-        ss += input;
+    if (argc > 3 && std::string(argv[3]) != "-") input = argv[3];
+    if (input.size() < 7) {
+        std::cout << "the signal needs at least 7 digits\n";
+        return -1;
     }
-    auto offset = std::stoi(ss.substr(0, 7));
-    auto data = convertToVector(ss);
 
-    std::cout << "starting... " << data.size() << ", offset: " << offset << '\n';
-    auto d = data;
-    for (auto i = 0u; i < 100; ++i)
-        measureTimeInSeconds(calculatePhase, d, offset);
+    PhaseWorkers workers(threads);
+    const RepeatedSignal once{ input, 1 };
+    PhaseBuffers signal(once.slice(0, once.size()), 0);
+    for (auto i = 0u; i < 100; ++i) {
+        INSTRUMENT_SCOPE("day16 part one phase", signal.digits.size());
+        prefixSumPhase(signal, workers);
+    }
+    std::cout << "First puzzle answer: ";
+    print(firstDigits(signal.digits));
+    std::cout << '\n';
 
-    std::cout << d.size() << '\n';
-    if (d.size() >= offset + 8)
-        print(std::vector<int>{d.begin() + offset, d.begin() + offset + 8});
+    const RepeatedSignal repeated{ input, repeats };
+    const auto offset = std::stoull(input.substr(0, 7));
+
+    std::cout << "starting... " << repeated.size() << ", offset: " << offset << '\n';
+    if (offset >= repeated.size()) {
+        std::cout << "offset is past the end of the signal\n";
+        return -1;
+    }
+    const auto secondHalf = offset >= repeated.size() / 2;
+    if ((mode == "suffix" || mode == "binomial") && !secondHalf) {
+        std::cout << "offset is in the first half, the " << mode << " kernel does not apply\n";
+        return -1;
+    }
+    if (mode == "binomial") {
+        Digits answer;
+        {
+            INSTRUMENT_SCOPE("day16 binomial", repeated.size() - offset);
+            answer = binomialDigits(repeated, offset, phases);
+        }
+        std::cout << "Second puzzle answer: ";
+        print(std::vector<int>{ answer.begin(), answer.end() });
+        std::cout << '\n';
+        return 0;
+    }
+    // the int32 prefix sums of the general kernel hold up to this many digits
+    const auto suffix = mode == "suffix" || (mode == "auto" && secondHalf);
+    if (!suffix && repeated.size() - offset > static_cast<uint64_t>(std::numeric_limits<int32_t>::max() / 9)) {
+        std::cout << "the message is too long for the prefix-sum kernel\n";
+        return -1;
+    }
+    PhaseBuffers message(repeated.slice(offset, repeated.size()), offset);
+    for (auto i = 0ull; i < phases; ++i) {
+        INSTRUMENT_SCOPE(suffix ? "day16 suffix-sum phase" : "day16 prefix-sum phase", message.digits.size());
+        if (suffix) suffixSumPhase(message.digits);
+        else prefixSumPhase(message, workers);
+    }
+    std::cout << "Second puzzle answer: ";
+    print(firstDigits(message.digits));
     std::cout << '\n';
     return 0;
 }
@@ -14,6 +14,14 @@
 #include <stack>
 #include <cassert>
 #include <queue>
+#include <unordered_set>
+#include <string_view>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <bit>
+
+#include "../common/turtle.hpp"
 
 namespace {
 
@@ -185,7 +193,6 @@ namespace {
                     answer = val;
                     if (shallOutputBreakExecution)
                         shouldBrake = true;
-                    std::cout << val << ',' << ' ';
                     ip += 2;
                     ++counter;
                     break;
@@ -333,60 +340,299 @@ namespace {
             return false;
         }
     };
+
+    // Camera image packed into one contiguous buffer, 1 for scaffold and 0 for open space.
+    // A ring of empty cells around the image lets the neighbour checks skip bounds tests.
+    struct ScaffoldGrid {
+        int width{ 0 };
+        int height{ 0 };
+        int stride{ 0 };
+        std::vector<uint8_t> cells;
+        turtle::State robot;
+
+        ScaffoldGrid(int w, int h) : width(w), height(h), stride(w + 2), cells((w + 2) * (h + 2)) {}
+
+        uint8_t* row(int y) { return cells.data() + (y + 1) * stride + 1; }
+        const uint8_t* row(int y) const { return cells.data() + (y + 1) * stride + 1; }
+
+        bool isScaffold(int x, int y) const {
+            return x >= -1 && x <= width && y >= -1 && y <= height && row(y)[x];
+        }
+    };
+
+    ScaffoldGrid parseCamera(std::string_view feed) {
+        auto width = static_cast<int>(feed.find('\n'));
+        if (width < 0) width = feed.size();
+        while (!feed.empty() && feed.back() == '\n') feed.remove_suffix(1);
+        const auto height = static_cast<int>((feed.size() + 1) / (width + 1));
+
+        ScaffoldGrid grid(width, height);
+        for (auto y = 0; y < height; ++y) {
+            const auto line = feed.substr(y * (width + 1), width);
+            auto* row = grid.row(y);
+            for (auto x = 0; x < width; ++x) {
+                row[x] = line[x] != '.';
+                if (const auto d = std::string_view("^>v<").find(line[x]); d != std::string_view::npos) {
+                    grid.robot = { x, y, static_cast<turtle::Dir>(d) };
+                }
+            }
+        }
+        return grid;
+    }
+
+    ScaffoldGrid readCamera(IntCodeComputer pc) {
+        std::string feed;
+        while (true) {
+            auto [val, opCode, _] = pc.run(0);
+            if (opCode == OpCodes::STOP) break;
+            feed.push_back(static_cast<char>(val));
+        }
+        return parseCamera(feed);
+    }
+
+    inline uint64_t load8(const uint8_t* p) {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    // Sum of x * y over scaffold cells whose four neighbours are scaffold too. Rows are scanned eight
+    // cells at a time: the up/down/left/right masks are plain 64-bit loads ANDed together, and the 0/1
+    // bytes of the result are reduced with two multiplies (count of hits, sum of their byte offsets).
+    uint64_t alignmentSum(ScaffoldGrid const& grid) {
+        uint64_t sum = 0;
+        for (auto y = 1; y + 1 < grid.height; ++y) {
+            const auto* up = grid.row(y - 1);
+            const auto* mid = grid.row(y);
+            const auto* down = grid.row(y + 1);
+            uint64_t rowSum = 0;
+            auto x = 0;
+            for (; x + 8 <= grid.width; x += 8) {
+                const auto cross = load8(up + x) & load8(down + x) & load8(mid + x - 1) & load8(mid + x) & load8(mid + x + 1);
+                const auto count = (cross * 0x0101010101010101ull) >> 56;
+                const auto offsets = (cross * 0x0001020304050607ull) >> 56;
+                rowSum += count * x + offsets;
+            }
+            for (; x < grid.width; ++x) {
+                rowSum += static_cast<uint64_t>(up[x] & down[x] & mid[x - 1] & mid[x] & mid[x + 1]) * x;
+            }
+            sum += rowSum * y;
+        }
+        return sum;
+    }
+
+    void benchmarkAlignment(int size) {
+        ScaffoldGrid grid(size, size);
+        uint32_t seed = 17;
+        for (auto y = 0; y < size; ++y) {
+            auto* row = grid.row(y);
+            for (auto x = 0; x < size; ++x) {
+                seed = seed * 1664525u + 1013904223u;
+                row[x] = (seed >> 28) < 12;
+            }
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto sum = alignmentSum(grid);
+        const auto end = std::chrono::steady_clock::now();
+        const auto seconds = std::chrono::duration<double>(end - start).count();
+        std::cout << size << "x" << size << " alignment sum: " << sum << ", " << seconds * 1000 << "ms, "
+                  << static_cast<double>(size) * size / seconds / 1e9 << " Gcells/s\n";
+    }
+
+    // the turns before a straight run: "L" or "R" after the first move, while the first one may also
+    // need none (the robot already faces the scaffold) or "L,L" (it faces away from it)
+    struct Move {
+        std::string_view turn;
+        int length;
+
+        bool operator==(Move const&) const = default;
+    };
+
+    const auto toString = [](Move const& m) {
+        return (m.turn.empty() ? std::string() : std::string(m.turn) + ',') + std::to_string(m.length);
+    };
+
+    // walks the scaffold from the robot: turn towards the only unvisited arm, go straight until the end of it
+    std::vector<Move> tracePath(ScaffoldGrid const& grid) {
+        auto robot = grid.robot;
+        std::vector<Move> path;
+        const auto open = [&](turtle::Dir d) { return grid.isScaffold(robot.x + turtle::DX[d], robot.y + turtle::DY[d]); };
+        while (true) {
+            // going straight on only happens first: afterwards the robot stands at the end of a run
+            std::optional<std::string_view> turn;
+            if (path.empty() && open(robot.dir)) turn = "";
+            for (auto [t, name] : { std::pair{ turtle::TURN_LEFT, "L" }, std::pair{ turtle::TURN_RIGHT, "R" } }) {
+                if (turn || !open(turtle::turn(robot.dir, t))) continue;
+                robot.dir = turtle::turn(robot.dir, t);
+                turn = name;
+            }
+            if (!turn && path.empty() && open(turtle::opposite(robot.dir))) {
+                robot.dir = turtle::opposite(robot.dir);
+                turn = "L,L";
+            }
+            if (!turn) break;
+
+            auto length = 0;
+            while (open(robot.dir)) {
+                robot.step();
+                ++length;
+            }
+            path.push_back({ *turn, length });
+        }
+        return path;
+    }
+
+    struct MovementProgram {
+        std::string routine;
+        std::vector<std::string> functions;
+    };
+
+    // Splits the path into a main routine calling at most `maxFunctions` functions, every line no longer
+    // than `limit` characters. At every position the existing functions that match are called first, then
+    // each prefix that fits is tried as a new function; an assignment can be reached along several orders,
+    // so dead (position, calls, definitions) states are memoized under one packed integer key.
+    class PathCompressor {
+    public:
+        PathCompressor(std::vector<Move> const& p, size_t maxFunctions = 3, size_t limit = 20)
+            : path(p), maxFunctions(maxFunctions), limit(limit), maxCalls((limit + 1) / 2),
+              fieldBits(static_cast<int>(std::bit_width(std::max(path.size(), maxCalls)))),
+              memoized(fieldBits * (2 + 2 * maxFunctions) <= 64) {
+            tokenLength.reserve(path.size());
+            for (auto& m : path) tokenLength.push_back(toString(m).size());
+        }
+
+        std::optional<MovementProgram> compress() {
+            calls.clear();
+            defs.clear();
+            failed.clear();
+            if (!search(0)) return {};
+
+            MovementProgram program;
+            for (auto c : calls) {
+                if (!program.routine.empty()) program.routine += ',';
+                program.routine += static_cast<char>('A' + c);
+            }
+            for (auto [start, len] : defs) {
+                std::string f;
+                for (auto i = start; i < start + len; ++i) {
+                    if (!f.empty()) f += ',';
+                    f += toString(path[i]);
+                }
+                program.functions.push_back(f);
+            }
+            return program;
+        }
+
+    private:
+        bool matches(std::pair<size_t, size_t> def, size_t pos) const {
+            auto [start, len] = def;
+            if (pos + len > path.size()) return false;
+            return std::equal(path.begin() + start, path.begin() + start + len, path.begin() + pos);
+        }
+
+        // pos, the call count and every definition's start and length, fieldBits each; a length is
+        // never 0, so states with fewer definitions cannot collide with longer ones
+        uint64_t stateKey(size_t pos) const {
+            uint64_t key = pos << fieldBits | calls.size();
+            for (auto [start, len] : defs) key = (key << fieldBits | start) << fieldBits | len;
+            return key;
+        }
+
+        bool search(size_t pos) {
+            if (pos == path.size()) return true;
+            if (calls.size() == maxCalls) return false;
+
+            const auto key = memoized ? stateKey(pos) : 0;
+            if (memoized && failed.contains(key)) return false;
+
+            for (auto f = 0u; f < defs.size(); ++f) {
+                if (!matches(defs[f], pos)) continue;
+                calls.push_back(f);
+                if (search(pos + defs[f].second)) return true;
+                calls.pop_back();
+            }
+
+            if (defs.size() < maxFunctions) {
+                size_t length = 0;
+                for (auto len = 1u; pos + len <= path.size(); ++len) {
+                    length += tokenLength[pos + len - 1] + (len > 1);
+                    if (length > limit) break;
+                    defs.push_back({ pos, len });
+                    calls.push_back(defs.size() - 1);
+                    if (search(pos + len)) return true;
+                    calls.pop_back();
+                    defs.pop_back();
+                }
+            }
+
+            if (memoized) failed.insert(key);
+            return false;
+        }
+
+        std::vector<Move> const& path;
+        std::vector<size_t> tokenLength;
+        size_t maxFunctions;
+        size_t limit;
+        size_t maxCalls;
+        int fieldBits;
+        bool memoized;      // false when the packed key would not fit 64 bits; the search is then just slower
+
+        std::vector<size_t> calls;
+        std::vector<std::pair<size_t, size_t>> defs;
+        std::unordered_set<uint64_t> failed;
+    };
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    if (argc > 1 && std::string_view(argv[1]) == "bench") {
+        benchmarkAlignment(argc > 2 ? std::stoi(argv[2]) : 10000);
+        return 0;
+    }
+
+
     std::vector<int64_t> input = {1,330,331,332,109,3300,1102,1182,1,15,1101,1455,0,24,1002,0,1,570,1006,570,36,101,0,571,0,1001,570,-1,570,1001,24,1,24,1106,0,18,1008,571,0,571,1001,15,1,15,1008,15,1455,570,1006,570,14,21102,58,1,0,1106,0,786,1006,332,62,99,21101,333,0,1,21102,1,73,0,1105,1,579,1101,0,0,572,1101,0,0,573,3,574,101,1,573,573,1007,574,65,570,1005,570,151,107,67,574,570,1005,570,151,1001,574,-64,574,1002,574,-1,574,1001,572,1,572,1007,572,11,570,1006,570,165,101,1182,572,127,102,1,574,0,3,574,101,1,573,573,1008,574,10,570,1005,570,189,1008,574,44,570,1006,570,158,1106,0,81,21101,0,340,1,1105,1,177,21101,477,0,1,1105,1,177,21102,1,514,1,21101,176,0,0,1106,0,579,99,21101,0,184,0,1105,1,579,4,574,104,10,99,1007,573,22,570,1006,570,165,101,0,572,1182,21101,0,375,1,21102,211,1,0,1106,0,579,21101,1182,11,1,21102,222,1,0,1106,0,979,21102,1,388,1,21102,1,233,0,1106,0,579,21101,1182,22,1,21102,1,244,0,1106,0,979,21101,0,401,1,21102,255,1,0,1106,0,579,21101,1182,33,1,21101,0,266,0,1106,0,979,21102,1,414,1,21101,277,0,0,1106,0,579,3,575,1008,575,89,570,1008,575,121,575,1,575,570,575,3,574,1008,574,10,570,1006,570,291,104,10,21101,1182,0,1,21101,313,0,0,1105,1,622,1005,575,327,1101,0,1,575,21102,327,1,0,1106,0,786,4,438,99,0,1,1,6,77,97,105,110,58,10,33,10,69,120,112,101,99,116,101,100,32,102,117,110,99,116,105,111,110,32,110,97,109,101,32,98,117,116,32,103,111,116,58,32,0,12,70,117,110,99,116,105,111,110,32,65,58,10,12,70,117,110,99,116,105,111,110,32,66,58,10,12,70,117,110,99,116,105,111,110,32,67,58,10,23,67,111,110,116,105,110,117,111,117,115,32,118,105,100,101,111,32,102,101,101,100,63,10,0,37,10,69,120,112,101,99,116,101,100,32,82,44,32,76,44,32,111,114,32,100,105,115,116,97,110,99,101,32,98,117,116,32,103,111,116,58,32,36,10,69,120,112,101,99,116,101,100,32,99,111,109,109,97,32,111,114,32,110,101,119,108,105,110,101,32,98,117,116,32,103,111,116,58,32,43,10,68,101,102,105,110,105,116,105,111,110,115,32,109,97,121,32,98,101,32,97,116,32,109,111,115,116,32,50,48,32,99,104,97,114,97,99,116,101,114,115,33,10,94,62,118,60,0,1,0,-1,-1,0,1,0,0,0,0,0,0,1,44,2,0,109,4,2101,0,-3,587,20101,0,0,-1,22101,1,-3,-3,21102,1,0,-2,2208,-2,-1,570,1005,570,617,2201,-3,-2,609,4,0,21201,-2,1,-2,1105,1,597,109,-4,2105,1,0,109,5,2101,0,-4,630,20102,1,0,-2,22101,1,-4,-4,21101,0,0,-3,2208,-3,-2,570,1005,570,781,2201,-4,-3,652,21002,0,1,-1,1208,-1,-4,570,1005,570,709,1208,-1,-5,570,1005,570,734,1207,-1,0,570,1005,570,759,1206,-1,774,1001,578,562,684,1,0,576,576,1001,578,566,692,1,0,577,577,21101,0,702,0,1105,1,786,21201,-1,-1,-1,1105,1,676,1001,578,1,578,1008,578,4,570,1006,570,724,1001,578,-4,578,21102,1,731,0,1105,1,786,1106,0,774,1001,578,-1,578,1008,578,-1,570,1006,570,749,1001,578,4,578,21101,0,756,0,1105,1,786,1105,1,774,21202,-1,-11,1,22101,1182,1,1,21102,1,774,0,1105,1,622,21201,-3,1,-3,1105,1,640,109,-5,2106,0,0,109,7,1005,575,802,20101,0,576,-6,21001,577,0,-5,1105,1,814,21102,0,1,-1,21102,1,0,-5,21101,0,0,-6,20208,-6,576,-2,208,-5,577,570,22002,570,-2,-2,21202,-5,45,-3,22201,-6,-3,-3,22101,1455,-3,-3,1202,-3,1,843,1005,0,863,21202,-2,42,-4,22101,46,-4,-4,1206,-2,924,21101,1,0,-1,1106,0,924,1205,-2,873,21101,35,0,-4,1105,1,924,2101,0,-3,878,1008,0,1,570,1006,570,916,1001,374,1,374,2101,0,-3,895,1102,2,1,0,1202,-3,1,902,1001,438,0,438,2202,-6,-5,570,1,570,374,570,1,570,438,438,1001,578,558,921,21001,0,0,-4,1006,575,959,204,-4,22101,1,-6,-6,1208,-6,45,570,1006,570,814,104,10,22101,1,-5,-5,1208,-5,41,570,1006,570,810,104,10,1206,-1,974,99,1206,-1,974,1102,1,1,575,21102,973,1,0,1105,1,786,99,109,-7,2106,0,0,109,6,21101,0,0,-4,21102,0,1,-3,203,-2,22101,1,-3,-3,21208,-2,82,-1,1205,-1,1030,21208,-2,76,-1,1205,-1,1037,21207,-2,48,-1,1205,-1,1124,22107,57,-2,-1,1205,-1,1124,21201,-2,-48,-2,1106,0,1041,21101,0,-4,-2,1105,1,1041,21102,1,-5,-2,21201,-4,1,-4,21207,-4,11,-1,1206,-1,1138,2201,-5,-4,1059,2102,1,-2,0,203,-2,22101,1,-3,-3,21207,-2,48,-1,1205,-1,1107,22107,57,-2,-1,1205,-1,1107,21201,-2,-48,-2,2201,-5,-4,1090,20102,10,0,-1,22201,-2,-1,-2,2201,-5,-4,1103,2102,1,-2,0,1106,0,1060,21208,-2,10,-1,1205,-1,1162,21208,-2,44,-1,1206,-1,1131,1106,0,989,21102,439,1,1,1105,1,1150,21101,477,0,1,1106,0,1150,21101,514,0,1,21102,1,1149,0,1105,1,579,99,21101,0,1157,0,1105,1,579,204,-2,104,10,99,21207,-3,22,-1,1206,-1,1138,1202,-5,1,1176,1201,-4,0,0,109,-6,2105,1,0,6,9,36,1,7,1,36,1,7,1,23,7,6,1,7,1,23,1,12,1,7,1,23,1,12,1,7,1,23,1,12,5,3,1,11,13,16,1,3,1,11,1,24,11,9,1,24,1,3,1,3,1,1,1,9,1,24,1,3,1,3,1,1,1,9,1,24,1,3,1,3,1,1,1,9,1,24,1,3,1,3,13,24,1,3,1,5,1,34,7,3,1,38,1,1,1,3,1,38,1,1,1,3,1,38,1,1,1,3,1,38,7,40,1,44,1,44,1,44,1,11,7,26,1,11,1,5,1,22,11,5,1,5,1,22,1,3,1,5,1,5,1,5,1,14,13,5,1,5,1,5,1,3,1,10,1,7,1,9,1,5,1,5,1,3,1,10,1,7,1,5,13,3,1,3,1,10,1,7,1,5,1,3,1,5,1,1,1,3,1,3,1,10,1,5,13,5,1,1,1,3,1,3,1,10,1,5,1,1,1,5,1,9,1,1,1,3,1,3,1,10,1,5,1,1,1,5,1,9,11,10,1,5,1,1,1,5,1,11,1,3,1,14,7,1,7,11,1,3,5,36,1,7,1,36,1,7,1,36,1,7,1,36,1,7,1,36,1,7,1,36,9,10
     };
 
     IntCodeComputer pc(input);
     pc.disableDebug();
-    // std::vector<std::vector<char>> map;
-    // map.push_back(std::vector<char>());
-    // while(true) {
-    //     auto [val, opCode, _] = pc.run(0);
-    //     if (val == 10) map.push_back(std::vector<char>());
-    //     else {
-    //         map.back().push_back(static_cast<char>(val));
-    //     }
-    //     if (opCode == OpCodes::STOP) break;
-    // }
-
-    // for (auto& line: map) {
-    //     for (auto ch: line) {
-    //         std::cout << ch << ' ';
-    //     }
-    //     std::cout << '\n';
-    // }
-    // std::cout << '\n';
-    pc.updateMemoryLocation(0,2);
-    const std::string s = "A,B,A,C,B,A,C,B,A,C\n";
-    const auto ss = {65,44,66,44,65,44,67,44,66,44,65,44,67,44,66,44,65,44,67,10};
-    const std::string A = "L,6,L,4,R,12\n";
-    const auto aa = {76,44,54,44,76,44,52,44,82,44,49,50,10};
-    const std::string B = "L,6,R,12,R,12,L,8\n";
-    const auto bb = {76,44,54,44,82,44,49,50,44,82,44,49,50,44,76,44,56,10};
-    const std::string C = "L,6,L,10,L,10,L,6\n";
-    const auto cc = {76,44,54,44,76,44,49,48,44,76,44,49,48,44,76,44,54,10};
-    for (auto ch: ss) {
-        pc.instructions.push(ch);
-    }
-    for (auto ch: aa) {
-        pc.instructions.push(ch);
-    }
-    for (auto ch: bb) {
-        pc.instructions.push(ch);
+
+    const auto grid = readCamera(pc);
+    std::cout << "First puzzle answer: " << alignmentSum(grid) << '\n';
+    const auto path = tracePath(grid);
+    if (path.empty()) {
+        std::cout << "The robot has no scaffold to walk\n";
+        return 1;
     }
 
-    for (auto ch: cc) {
-        pc.instructions.push(ch);
+    const auto start = std::chrono::steady_clock::now();
+    const auto program = PathCompressor(path).compress();
+    const auto end = std::chrono::steady_clock::now();
+    if (!program) {
+        std::cout << "Path cannot be compressed\n";
+        return 1;
     }
+    std::cout << "compressed " << path.size() << " moves in "
+              << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << "us\n";
 
-    for (auto ch : { 110,10 }) pc.instructions.push(ch);
-    while(true) {
-        auto opCode = std::get<1>(pc.run(0));
+    const auto feed = [&pc](std::string const& line) {
+        for (auto ch : line) pc.instructions.push(ch);
+        pc.instructions.push('\n');
+    };
+    pc.updateMemoryLocation(0, 2);
+    feed(program->routine);
+    for (auto& f : program->functions) feed(f);
+    // the VM always asks for three functions, pad with a single turn that is never called
+    for (auto i = program->functions.size(); i < 3; ++i) feed("L");
+    feed("n");
+
+    int64_t dust = 0;
+    while (true) {
+        auto [val, opCode, _] = pc.run(0);
         if (opCode == OpCodes::STOP) break;
+        dust = val;
     }
+    std::cout << "Second puzzle answer: " << dust << '\n';
     return 0;
 }
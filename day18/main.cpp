@@ -15,9 +15,19 @@
 #include <cassert>
 #include <queue>
 #include <list>
-#include <fstream>
 #include <thread>
 #include <bitset>
+#include <bit>
+#include <chrono>
+#include <memory>
+#include <limits>
+#include <atomic>
+#include <barrier>
+
+#include "../common/flat_hash_map.hpp"
+#include "../common/concurrent_min_map.hpp"
+#include "../common/grid_bfs.hpp"
+#include "../common/grid_file.hpp"
 
 namespace {
 
@@ -45,29 +55,11 @@ using KEYS = std::map<char, Position>;
 KEYS keys;
 std::set<uint32_t> steps_sum;
 
-const auto loadData = [](auto path){
-    std::vector<std::vector<char>> res;
-    {
-        char ch;
-        std::fstream fs(path, std::fstream::in);
-        res.push_back({});
-        while (fs.get(ch)) {
-            if(ch == '\n') {
-                res.back().push_back(ch);
-                res.push_back({});
-            }
-            else {
-                res.back().push_back(ch);
-            }
-        }
-        fs.close();
-    }
-    return res;
-};
 const auto printData = [](auto& data) {
     for (auto& line: data) {
         for (auto ch: line)
             std::cout << ch;
+        std::cout << '\n';
     }
 };
 const auto getInitialPosition = [](auto& data) -> Position {
@@ -105,90 +97,331 @@ const auto getKeysAndDoorsLocation = [](auto& input){
     return locations;
 };
 
-int32_t bfs(MAP map, Position startingPos, int32_t expectedSize = -1){
-    std::queue<Position> q;
-    std::set<std::tuple<int, int, int32_t>> visited;
-
-    std::vector<int> x_dir = {-1, 0 ,0, 1};
-    std::vector<int> y_dir = {0, -1 ,1, 0};
-    std::bitset<26> keys_collected;
-    const auto total_keys = expectedSize == -1? keys.size():expectedSize;
+// The vault compressed to its points of interest: keys are nodes 0..25 (by letter), robot starts
+// follow as 26, 27, ... Each node knows the distance to every key it can reach, the doors on that
+// way and the keys that would be picked up in passing. Those masks come from a single shortest
+// path per pair, which is exact as long as the corridors form a tree, as they do in the puzzle.
+constexpr auto KEY_COUNT = 26;
 
+struct KeyEdge {
+    int32_t distance{ -1 };
+    uint32_t doors{ 0 };
+    uint32_t keysOnPath{ 0 };
+};
 
-    q.push(startingPos);
-    while (not q.empty()) {
-        auto m = q.front();
-        q.pop();
+struct KeyGraph {
+    std::vector<std::array<KeyEdge, KEY_COUNT>> edges;
+    uint32_t allKeys{ 0 };
+    int robots{ 0 };
+};
 
-        keys_collected = m.keys_;
+const auto isKey = [](char c) { return c >= 'a' && c <= 'z'; };
+const auto isDoor = [](char c) { return c >= 'A' && c <= 'Z'; };
+const auto isOpen = [](char c) { return c != gridbfs::WALL; };
+
+// one BFS per node over the grid; each cell inherits the doors and keys of the cell it was reached from
+const auto keyDistancesFrom = [](gridbfs::Grid const& grid, uint32_t from) {
+    std::array<KeyEdge, KEY_COUNT> edges{};
+    std::vector<KeyEdge> cells(grid.size());
+    gridbfs::bfs(grid, from, isOpen, [&](uint32_t cell, uint32_t parent, int32_t distance) {
+        auto path = cells[parent];
+        const char c = grid[parent];
+        if (isDoor(c)) path.doors |= 1u << (c - 'A');
+        if (isKey(c) && parent != from) path.keysOnPath |= 1u << (c - 'a');
+        path.distance = distance;
+        cells[cell] = path;
+        if (isKey(grid[cell]) && distance > 0) edges[grid[cell] - 'a'] = path;
+        return false;
+    });
+    return edges;
+};
 
-        if (keys_collected.count() == total_keys)
-            return m.steps;
+const auto buildKeyGraph = [](auto const& map, std::vector<Position> const& starts) {
+    const auto grid = gridbfs::Grid::fromLines(map);
+    const auto cellOf = [&](Position p) { return grid.index(static_cast<int>(p.y), static_cast<int>(p.x)); };
+    KeyGraph graph;
+    graph.robots = static_cast<int>(starts.size());
+    graph.edges.resize(KEY_COUNT + starts.size());
+    for (auto& [key, position] : keys) {
+        graph.allKeys |= 1u << (key - 'a');
+        graph.edges[key - 'a'] = keyDistancesFrom(grid, cellOf(position));
+    }
+    for (auto i = 0u; i < starts.size(); ++i)
+        graph.edges[KEY_COUNT + i] = keyDistancesFrom(grid, cellOf(starts[i]));
+    return graph;
+};
 
-        for (int i = 0; i < 4; ++i) {
+// A robot only ever stands on its start or on a key of its own region, so the positions of all
+// robots pack into a second 26-bit "occupied keys" mask and one 64-bit state holds them all. This
+// needs every key to be reachable by exactly one robot (separate vaults); the move generator keeps
+// robot positions in a fixed array, so vaults with more than MAX_ROBOTS starts are refused too.
+constexpr auto MAX_ROBOTS = 32;
+
+using KeyOwners = std::array<int, KEY_COUNT>;
+
+const auto keyOwners = [](KeyGraph const& graph) -> std::optional<KeyOwners> {
+    if (graph.robots > MAX_ROBOTS) return std::nullopt;
+    KeyOwners owner;
+    owner.fill(-1);
+    for (auto key = 0; key < KEY_COUNT; ++key) {
+        if (!((graph.allKeys >> key) & 1)) continue;
+        for (auto robot = 0; robot < graph.robots; ++robot) {
+            if (graph.edges[KEY_COUNT + robot][key].distance < 0) continue;
+            if (owner[key] != -1) return std::nullopt;
+            owner[key] = robot;
+        }
+        if (owner[key] == -1) return std::nullopt;
+    }
+    return owner;
+};
 
-            const auto x = m.x + x_dir[i];
-            const auto y = m.y + y_dir[i];
+const auto packKeyState = [](uint64_t mask, uint64_t occupied) { return mask | occupied << KEY_COUNT; };
+
+// Calls move(nextMask, nextOccupied, length) for every walk of one robot to a key whose doors are
+// open. Dominance pruning: a walk that passes over an uncollected key is skipped, as stopping at
+// that key first reaches the same state at no extra cost.
+template <typename Move>
+void forEachKeyMove(KeyGraph const& graph, KeyOwners const& owner, uint32_t mask, uint32_t occupied, Move move) {
+    std::array<int, MAX_ROBOTS> robotAt;
+    for (auto robot = 0; robot < graph.robots; ++robot)
+        robotAt[robot] = KEY_COUNT + robot;
+    for (auto bits = occupied; bits; bits &= bits - 1) {
+        const auto key = std::countr_zero(bits);
+        robotAt[owner[key]] = key;
+    }
 
-            if (x >= map.size() || y >= map[0].size()) continue;
-            const char c = map[x][y];
-            if (c == '#') continue;
+    for (auto robot = 0; robot < graph.robots; ++robot) {
+        const auto node = robotAt[robot];
+        const auto leaving = node < KEY_COUNT ? 1u << node : 0u;
+        for (auto key = 0; key < KEY_COUNT; ++key) {
+            const auto& edge = graph.edges[node][key];
+            if (edge.distance < 0 || (mask >> key) & 1) continue;
+            if ((edge.doors | edge.keysOnPath) & ~mask) continue;
+            move(mask | 1u << key, (occupied & ~leaving) | 1u << key, edge.distance);
+        }
+    }
+}
 
+uint64_t expandedStates = 0;
+
+// Joint Dijkstra for K robots over (collected keys, occupied keys); every transition is one robot
+// walking to a key. -1 when the vault is not solvable, its robots share a region or there are
+// more than MAX_ROBOTS of them.
+const auto collectKeys = [](KeyGraph const& graph) -> int32_t {
+    const auto owner = keyOwners(graph);
+    if (!owner) return -1;
+
+    using State = std::pair<int32_t, uint64_t>;
+    FlatHashMap<int32_t> best;
+    std::priority_queue<State, std::vector<State>, std::greater<>> q;
+    best.tryEmplace(0, 0);
+    q.push({ 0, 0 });
+    while (!q.empty()) {
+        const auto [distance, state] = q.top();
+        q.pop();
+        const auto mask = static_cast<uint32_t>(state & ((1u << KEY_COUNT) - 1));
+        const auto occupied = static_cast<uint32_t>(state >> KEY_COUNT);
+        if (*best.find(state) < distance) continue;
+        ++expandedStates;
+        if (mask == graph.allKeys) return distance;
+
+        forEachKeyMove(graph, *owner, mask, occupied, [&](uint32_t nextMask, uint32_t nextOccupied, int32_t length) {
+            const auto next = packKeyState(nextMask, nextOccupied);
+            const auto d = distance + length;
+            auto [stored, inserted] = best.tryEmplace(next, d);
+            if (!inserted) {
+                if (*stored <= d) return;
+                *stored = d;
+            }
+            q.push({ d, next });
+        });
+    }
+    return -1;
+};
 
-            if (visited.count(std::make_tuple(x, y, keys_collected.to_ulong()))) continue;
+// Delta-stepping over the same (mask, occupied) states for several threads: distances live in a
+// lock-free ConcurrentMinMap, states are bucketed by distance / delta and every bucket is drained in
+// rounds whose frontier is split across the threads. Relaxations inside a bucket may repeat a
+// state, buckets are settled in order, so the result is exactly the Dijkstra distance.
+// The worker threads are started once and live for the whole search: each round the caller
+// publishes the frontier, releases them through one barrier and meets them at a second one.
+const auto collectKeysParallel = [](KeyGraph const& graph, int threads) -> int32_t {
+    const auto owner = keyOwners(graph);
+    if (!owner) return -1;
+    if (graph.allKeys == 0) return 0;
+
+    int64_t lengths = 0, edges = 0;
+    for (auto const& node : graph.edges)
+        for (auto const& edge : node)
+            if (edge.distance > 0) { lengths += edge.distance; ++edges; }
+    const int32_t delta = edges ? std::max<int64_t>(1, lengths / edges / 2) : 1;
+
+    ConcurrentMinMap distances;
+    std::atomic<int32_t> best{ std::numeric_limits<int32_t>::max() };
+    std::atomic<uint64_t> expanded{ 0 };
+    std::vector<std::vector<uint64_t>> buckets(1);
+    distances.relax(0, 0);
+    buckets[0].push_back(0);
+
+    using Pushes = std::vector<std::pair<int32_t, uint64_t>>;
+    std::vector<Pushes> pushes(threads);
+    std::vector<uint64_t> frontier;
+
+    const auto work = [&](int worker, std::size_t from, std::size_t to) {
+        auto& out = pushes[worker];
+        uint64_t done = 0;
+        for (auto i = from; i < to; ++i) {
+            const auto state = frontier[i];
+            const auto distance = distances.get(state);
+            ++done;
+            const auto mask = static_cast<uint32_t>(state & ((1u << KEY_COUNT) - 1));
+            const auto occupied = static_cast<uint32_t>(state >> KEY_COUNT);
+            forEachKeyMove(graph, *owner, mask, occupied, [&](uint32_t nextMask, uint32_t nextOccupied, int32_t length) {
+                const auto d = distance + length;
+                if (d >= best.load(std::memory_order_relaxed)) return;
+                const auto next = packKeyState(nextMask, nextOccupied);
+                if (!distances.relax(next, d)) return;
+                if (nextMask == graph.allKeys) {
+                    for (auto seen = best.load(); d < seen && !best.compare_exchange_weak(seen, d););
+                    return;
+                }
+                out.push_back({ d, next });
+            });
+        }
+        expanded += done;
+    };
+    // worker w takes the w-th of `threads` equal slices of the published frontier
+    const auto share = [&](int worker) {
+        const auto chunk = (frontier.size() + threads - 1) / threads;
+        work(worker, std::min(frontier.size(), worker * chunk), std::min(frontier.size(), (worker + 1) * chunk));
+    };
+
+    std::barrier roundStart(threads), roundEnd(threads);
+    bool finished = false;
+    std::vector<std::thread> pool;
+    for (auto worker = 1; worker < threads; ++worker) {
+        pool.emplace_back([&, worker] {
+            for (;;) {
+                roundStart.arrive_and_wait();
+                if (finished) return;
+                share(worker);
+                roundEnd.arrive_and_wait();
+            }
+        });
+    }
 
-            const auto cp = keys_collected;
-            if (c >= 'A' && c <= 'Z') {
-                if (!keys_collected.test(c - 'A')) continue;
+    for (std::size_t bucket = 0; bucket < buckets.size() && static_cast<int64_t>(bucket) * delta <= best; ++bucket) {
+        while (!buckets[bucket].empty()) {
+            frontier = std::move(buckets[bucket]);
+            buckets[bucket].clear();
+            std::size_t moves = 0;
+            for (const auto state : frontier)
+                moves += KEY_COUNT - std::popcount(static_cast<uint32_t>(state & ((1u << KEY_COUNT) - 1)));
+            distances.reserve(moves);
+
+            // small rounds are not worth waking the workers for
+            if (threads == 1 || frontier.size() < 256) work(0, 0, frontier.size());
+            else {
+                roundStart.arrive_and_wait();
+                share(0);
+                roundEnd.arrive_and_wait();
             }
-            else if (c >= 'a' && c <= 'z') {
-                if (!keys_collected.test(c - 'a')) {
-                    keys_collected.set(c-'a');
+
+            for (auto& out : pushes) {
+                for (const auto& [d, state] : out) {
+                    if (distances.get(state) != d) continue;     // improved again since
+                    const auto target = static_cast<std::size_t>(d / delta);
+                    if (target >= buckets.size()) buckets.resize(target + 1);
+                    buckets[target].push_back(state);
                 }
+                out.clear();
             }
-
-            visited.emplace(x, y, keys_collected.to_ulong());
-            q.push({x, y, m.steps + 1, static_cast<int32_t>(keys_collected.to_ulong())});
-            keys_collected = cp;
         }
-
     }
+    finished = true;
+    if (threads > 1) roundStart.arrive_and_wait();
+    for (auto& thread : pool) thread.join();
 
-    return -1;
-}
-
-const auto collectDataAndIgnoreDoors = [](MAP& map, Position pos){
-    const auto max_x = map.size();
-    const auto max_y = map[0].size();
+    expandedStates += expanded;
+    const auto answer = best.load();
+    return answer == std::numeric_limits<int32_t>::max() ? -1 : answer;
+};
 
-    const auto x_start = (max_x / 2) > pos.x?0:pos.x-1;
-    const auto y_start = (max_y / 2) > pos.y?0:pos.y-1;
+// Memo of int32 values over a huge, sparsely used index space: 4K-entry pages are allocated on
+// first write, so the 27 x 2^26 table of a single-robot vault only costs the pages it touches.
+class PagedMemo {
+public:
+    static constexpr int32_t UNKNOWN = -1;
+    static constexpr int PAGE_BITS = 12;
 
-    const auto x_end = x_start == 0?pos.x+1:max_x;
-    const auto y_end = y_start == 0?pos.y+1:max_y;
+    explicit PagedMemo(uint64_t size) : pages((size >> PAGE_BITS) + 1) {}
 
-    std::vector<char> doors;
-    std::vector<char> k;
-    for (auto i = x_start; i < x_end; ++i) {
-        for (auto j = y_start; j < y_end; ++j){
-            if (map[i][j] >= 'a' && map[i][j] <= 'z') k.push_back(map[i][j]);
-            else if (map[i][j] >= 'A' && map[i][j] <= 'Z') doors.push_back(map[i][j]);
-        }
+    int32_t get(uint64_t index) const {
+        auto const& page = pages[index >> PAGE_BITS];
+        return page ? page[index & PAGE_MASK] : UNKNOWN;
     }
 
-    for (auto i = x_start; i < x_end; ++i) {
-        for (auto j = y_start; j < y_end; ++j){
-            if (map[i][j] >= 'A' && map[i][j] <= 'Z') {
-                const auto ch = map[i][j];
-                if (std::none_of(k.begin(), k.end(), [ch](char c){return c == ch+32;}))
-                    if (std::any_of(keys.begin(), keys.end(), [ch](auto const& c){return c.first == ch+32;})) {
-                        map[i][j] = '.';
-                    }
-            }
+    void set(uint64_t index, int32_t value) {
+        auto& page = pages[index >> PAGE_BITS];
+        if (!page) {
+            page = std::make_unique<int32_t[]>(PAGE_SIZE);
+            std::fill(page.get(), page.get() + PAGE_SIZE, UNKNOWN);
+            ++allocated;
         }
+        page[index & PAGE_MASK] = value;
     }
 
-    return std::tuple(k, doors);
+    std::size_t allocatedPages() const { return allocated; }
+
+private:
+    static constexpr uint64_t PAGE_SIZE = uint64_t{ 1 } << PAGE_BITS;
+    static constexpr uint64_t PAGE_MASK = PAGE_SIZE - 1;
+
+    std::vector<std::unique_ptr<int32_t[]>> pages;
+    std::size_t allocated{ 0 };
+};
+
+// Top-down DP: the shortest way to collect the remaining keys from a state. Only states reachable
+// from the start are ever evaluated, and every one of them once, which beats Dijkstra on vaults
+// whose chokepoints leave few reachable masks but many equally short partial orders.
+// A single robot is memoized in the 27 x 2^26 paged table indexed by (node, mask); several robots
+// fall back to the hash map keyed like the Dijkstra states.
+const auto collectKeysMemo = [](KeyGraph const& graph) -> int32_t {
+    const auto owner = keyOwners(graph);
+    if (!owner) return -1;
+    constexpr int32_t UNREACHABLE = std::numeric_limits<int32_t>::max() / 2;
+
+    PagedMemo table(graph.robots == 1 ? uint64_t{ KEY_COUNT + 1 } << KEY_COUNT : 0);
+    FlatHashMap<int32_t> hashed;
+    const auto lookup = [&](uint32_t mask, uint32_t occupied) -> int32_t {
+        if (graph.robots == 1) {
+            const uint64_t node = occupied ? std::countr_zero(occupied) : KEY_COUNT;
+            return table.get(node << KEY_COUNT | mask);
+        }
+        const auto found = hashed.find(packKeyState(mask, occupied));
+        return found ? *found : PagedMemo::UNKNOWN;
+    };
+    const auto store = [&](uint32_t mask, uint32_t occupied, int32_t value) {
+        if (graph.robots == 1) {
+            const uint64_t node = occupied ? std::countr_zero(occupied) : KEY_COUNT;
+            table.set(node << KEY_COUNT | mask, value);
+        }
+        else hashed.tryEmplace(packKeyState(mask, occupied), value);
+    };
+
+    const auto remaining = [&](auto& self, uint32_t mask, uint32_t occupied) -> int32_t {
+        if (mask == graph.allKeys) return 0;
+        if (const auto known = lookup(mask, occupied); known != PagedMemo::UNKNOWN) return known;
+        ++expandedStates;
+        auto best = UNREACHABLE;
+        forEachKeyMove(graph, *owner, mask, occupied, [&](uint32_t nextMask, uint32_t nextOccupied, int32_t length) {
+            best = std::min(best, length + self(self, nextMask, nextOccupied));
+        });
+        store(mask, occupied, best);
+        return best;
+    };
+    const auto answer = remaining(remaining, 0, 0);
+    return answer >= UNREACHABLE ? -1 : answer;
 };
 
 }
@@ -201,16 +434,75 @@ int main(int argc, char** argv)
     }
 
     const std::string path = argv[1];
-    const auto input = loadData(path);
+    const auto input = gridfile::load(path);
     //printData(input);
 
-    auto map = input;
+    auto map = input.copy<MAP>();
     auto startingPosition = getInitialPosition(input);
     const auto locations = getKeysAndDoorsLocation(input);
 
-    auto keys_ = keys;
+    // "solve [dijkstra|memo|parallel [threads]]": the map exactly as given, printed as
+    // "<answer> <states expanded>" for bench/maze_sweep; "compare [threads]": all solvers side by side;
+    // "scale [max threads]": the parallel solver from 1 thread up
+    const std::string mode = argc > 2 ? argv[2] : "";
+    const std::string variant = argc > 3 ? argv[3] : "dijkstra";
+    // where each mode takes its thread count, and how many parameters it takes at most
+    const auto threadsAt = mode == "solve" ? 4 : 3;
+    const auto maxArgs = mode == "solve" ? (variant == "parallel" ? 5 : 4) : mode == "compare" || mode == "scale" ? 4 : 2;
+    if (argc > maxArgs) {
+        std::cout << (maxArgs == 2 ? "unknown mode " + mode : std::string("too many parameters")) << '\n';
+        return -1;
+    }
+    const auto defaultThreads = mode == "scale" ? 32 : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const auto threads = argc > threadsAt ? std::stoi(argv[threadsAt]) : defaultThreads;
+    if (threads < 1) {
+        std::cout << "thread count must be at least 1\n";
+        return -1;
+    }
+    const auto timed = [](auto solver) {
+        expandedStates = 0;
+        const auto start = std::chrono::steady_clock::now();
+        const auto answer = solver();
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return std::tuple(answer, expandedStates, elapsed * 1000);
+    };
+    if (mode == "solve") {
+        const auto graph = buildKeyGraph(input, getInitialPositions(input));
+        const auto answer = variant == "memo" ? collectKeysMemo(graph)
+            : variant == "parallel" ? collectKeysParallel(graph, threads) : collectKeys(graph);
+        std::cout << answer << ' ' << expandedStates << '\n';
+        return 0;
+    }
+    if (mode == "compare") {
+        const auto graph = buildKeyGraph(input, getInitialPositions(input));
+        const auto print = [](const char* name, auto result) {
+            const auto [answer, states, ms] = result;
+            std::cout << name << ": " << answer << ", " << states << " states, " << ms << "ms\n";
+        };
+        print("dijkstra", timed([&] { return collectKeys(graph); }));
+        print("memo    ", timed([&] { return collectKeysMemo(graph); }));
+        print("parallel", timed([&] { return collectKeysParallel(graph, threads); }));
+        return 0;
+    }
+    if (mode == "scale") {
+        const auto graph = buildKeyGraph(input, getInitialPositions(input));
+        const auto maxThreads = threads;
+        const auto [reference, referenceStates, referenceMs] = timed([&] { return collectKeys(graph); });
+        std::cout << "dijkstra: " << reference << ", " << referenceMs << "ms\n";
+        for (auto t = 1; t <= maxThreads; t *= 2) {
+            const auto [answer, states, ms] = timed([&] { return collectKeysParallel(graph, t); });
+            std::cout << t << " threads: " << answer << (answer == reference ? "" : " MISMATCH") << ", "
+                      << states << " states, " << ms << "ms\n";
+        }
+        return 0;
+    }
 
-    std::cout << "First puzzle answer: " <<  bfs(map, startingPosition) << '\n';
+    if (const auto starts = getInitialPositions(input); starts.size() > 1) {
+        std::cout << "Vault with " << starts.size() << " robots: " << collectKeys(buildKeyGraph(input, starts)) << '\n';
+        return 0;
+    }
+
+    std::cout << "First puzzle answer: " << collectKeys(buildKeyGraph(input, { startingPosition })) << '\n';
 
     map[startingPosition.x][startingPosition.y] = '#';
     map[startingPosition.x - 1][startingPosition.y] = '#';
@@ -222,21 +514,7 @@ int main(int argc, char** argv)
     map[startingPosition.x - 1][startingPosition.y + 1] = '@';
     map[startingPosition.x - 1][startingPosition.y - 1] = '@';
 
-    auto positions = getInitialPositions(map);
-
-
-    //int -> (keys, doors)
-    std::map<int, std::tuple<std::vector<char>, std::vector<char>>> tmp;
-    int i = 0;
-    for (auto p : positions) {
-        tmp[i++] = collectDataAndIgnoreDoors(map, p);
-    }
-
-    int32_t sum = 0;
-
-    for (auto i = 0; i < 4; ++i) {
-        sum += bfs(map, positions[i], std::get<0>(tmp[i]).size());
-    }
+    const auto sum = collectKeys(buildKeyGraph(map, getInitialPositions(map)));
     std::cout << "second puzzle: " << sum << '\n';
     return 0;
 }
@@ -14,243 +14,154 @@
 #include <cassert>
 #include <queue>
 #include <list>
-#include <fstream>
 #include <thread>
 #include <chrono>
 #include <unordered_set>
+#include <limits>
 
-namespace {
-struct Position {
-    std::size_t x;
-    std::size_t y;
-    int steps;
-    int level;
-};
+#include "../common/flat_hash_map.hpp"
+#include "../common/grid_bfs.hpp"
+#include "../common/grid_file.hpp"
 
-bool operator == (Position a, Position b) { return a.x == b.x && a.y == b.y; }
-bool operator <  (Position a, Position b) { return (a.x != b.x) ? (a.x < b.x) : (a.y < b.y); }
+namespace {
 
-struct Portal {
-    Position out;
-    Position in;
+// The donut on a padded grid: every portal tile ('.' next to a label) knows the tile it jumps to
+// and whether the jump goes one level deeper (inner ring) or back out (outer ring).
+struct Donut {
+    gridbfs::Grid grid;
+    gridbfs::Portals portals;
+    uint32_t start{ 0 };
+    uint32_t end{ 0 };
+    int portalPairs{ 0 };
 };
 
-
-using map_type = std::vector<std::vector<char>>;
-std::map<std::string, Portal> m;
-std::vector<map_type> maps;
-std::map<Position, Position> portals;
-std::map<Position, int> depth_change;
-
-
-const auto loadData = [](auto path) {
-    std::vector<std::vector<char>> res;
-    {
-        char ch;
-        bool insertNewLine = false;
-        std::fstream fs(path, std::fstream::in);
-        res.push_back({});
-        while (fs.get(ch)) {
-            if (insertNewLine) {
-                res.push_back({});
-                insertNewLine = false;
-            }
-            res.back().push_back(ch);
-            if (ch == '\n') {
-                insertNewLine = true;
-            }
+const auto isLabel = [](char c) { return c >= 'A' && c <= 'Z'; };
+const auto isOpen = [](char c) { return c == '.'; };
+
+const auto parseDonut = [](auto const& input) {
+    Donut donut;
+    donut.grid = gridbfs::Grid::fromLines(input, ' ');
+    auto& grid = donut.grid;
+    const auto mazeWidth = grid.width - 2;
+    const auto mazeHeight = grid.height - 2;
+    donut.portals = gridbfs::Portals(grid.size());
+
+    std::map<std::string, std::vector<std::pair<uint32_t, bool>>> labels;
+    for (auto cell = 0u; cell < grid.size(); ++cell) {
+        if (!isOpen(grid[cell])) continue;
+        for (auto dir = 0; dir < 4; ++dir) {
+            const auto near = cell + grid.offsets[dir];
+            if (!isLabel(grid[near])) continue;
+            const auto far = near + grid.offsets[dir];
+            // labels read left to right / top to bottom whichever side of the tile they are on
+            const auto reversed = grid.offsets[dir] < 0;
+            const std::string name = reversed ? std::string{ grid[far], grid[near] } : std::string{ grid[near], grid[far] };
+            const auto outer = grid.x(far) == 0 || grid.y(far) == 0
+                || grid.x(far) == mazeWidth - 1 || grid.y(far) == mazeHeight - 1;
+            labels[name].push_back({ cell, outer });
         }
-        fs.close();
     }
-    return res;
-};
-const auto printData = [](auto& data, int level, int x=0, int y=0, char c=0) {
-    if (x != 0 && y != 0)
-        data[x][y] = '*';
 
-    std::cout << "\n\tLEVEL: " << level << '\n';
-    for (auto& line : data) {
-        for (auto ch : line)
-            std::cout << ch;
-    }
-    if (x != 0 && y != 0){
-        data[x][y] = c;
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
-    }
-};
-const auto findPosition = [](auto& input, char mark, char otherMark) -> Position {
-    std::vector<Position> pos;
-    for (auto i = 0u; i < input.size(); ++i) {
-        if (pos.size() == 2) break;
-        for (auto j = 0u; j < input[i].size(); ++j) {
-            if (input[i][j] == mark) {
-                if (input[i + 1][j] == otherMark) {
-                    pos.push_back({ i,j });
-                    pos.push_back({ i + 1,j });
-                    break;
-                }
-                else if (input[i][j + 1] == otherMark) {
-                    pos.push_back({ i,j });
-                    pos.push_back({ i,j + 1 });
-                    break;
-                }
+    for (auto& [name, ends] : labels) {
+        if (name == "AA") donut.start = ends.front().first;
+        else if (name == "ZZ") donut.end = ends.front().first;
+        else if (ends.size() == 2) {
+            for (auto i = 0; i < 2; ++i) {
+                const auto [cell, outer] = ends[i];
+                donut.portals.link(cell, ends[1 - i].first, outer ? -1 : 1);
             }
+            ++donut.portalPairs;
         }
     }
-    assert(pos.size() == 2);
-    auto& first = pos[0];
-    auto& second = pos[1];
-    if (first.x == second.x) {
-        //horizontal
-        if (first.y > 1)
-            if (input[first.x][first.y - 1] == '.')
-                return { first.x, first.y - 1 }; // .AA
-        if (input[first.x][second.y + 1] == '.')
-            return { first.x, second.y + 1 }; // AA.
-    }
-    else { //vertical
-        if (first.x > 1)                            // .
-            if (input[first.x - 1][first.y] == '.')   // A
-                return { first.x - 1, first.y };        // A
-
-
-        if (input[second.x + 1][first.y] == '.')      // A
-            return { second.x + 1, first.y };           // A
-    }                                               // .
-    assert(false);
-    return {};
-};
-const auto getStartingPosition = [](auto& input) -> Position {
-    return findPosition(input, 'A', 'A');
-};
-const auto getEndingPos = [](auto& input) -> Position {
-    return findPosition(input, 'Z', 'Z');
+    return donut;
 };
-const auto searchPortals = [](auto const& input) {
-    const auto width = input[0].size();
-    //scan for horizontal ones
-    for (auto i = 0u; i < input.size(); ++i) {
-        for (auto j = 0u; j < input[i].size() - 1; ++j) {
-            if ((input[i][j] >= 'A' && input[i][j] <= 'Z') && (input[i][j + 1] >= 'A' && input[i][j + 1] <= 'Z')) {
-                const std::size_t x = i;
-                std::size_t y = 0;
-                if (j > 1)
-                    if (input[i][j - 1] == '.') {
-                        y = j;
-                    }
-                if (input[i][j + 2] == '.') {
-                    y = j + 1;
-                }
-                std::string portalName;
-                portalName += input[i][j];
-                portalName += input[i][j + 1];
 
-                if (j == 0 || i ==0 || i == width - 2 || j == width -2 || i == width - 3 || j == width -3){
-                    m[portalName].out = { x, y };
-                    depth_change[{x,y}] = -1;
-                }
-                else {
-                    m[portalName].in = { x, y };
-                    depth_change[{x,y}] = 1;
-                }
-            }
-        }
-    }
-
-    for (auto i = 0u; i < width; ++i) {
-        for (auto j = 0u; j < input.size() - 1; ++j) {
-            if ((input[j][i] >= 'A' && input[j][i] <= 'Z') && (input[j + 1][i] >= 'A' && input[j + 1][i] <= 'Z')) {
-                std::size_t x = 0;
-                const std::size_t y = i;
-                if (j > 1)
-                    if (input[j - 1][i] == '.') {
-                        x = j;
-                    }
-                if (j < input.size() - 2u)
-                    if (input[j + 2][i] == '.') {
-                        x = j + 1;
-                    }
-                std::string portalName;
-                portalName += input[j][i];
-                portalName += input[j + 1][i];
+// The donut contracted to its portal tiles (AA and ZZ included): one BFS per tile gives the walking
+// distance to every other portal tile on the same level, the jumps themselves are separate edges.
+struct PortalGraph {
+    struct Node {
+        uint32_t tile{ 0 };
+        int partner{ -1 };
+        int depthChange{ 0 };
+        std::vector<std::pair<int, int32_t>> walks;
+    };
+    std::vector<Node> nodes;
+    int start{ -1 };
+    int end{ -1 };
+};
 
-                if (j == 0 || i ==0 || i == input.size() - 2u || j == input.size() -2u|| i == input.size() - 3u || j == input.size() -3u) {
-                    m[portalName].out = { x, y };
-                    depth_change[{x,y}] = -1;
-                }
-                else{
-                    m[portalName].in = { x, y };
-                    depth_change[{x,y}] = 1;
-                }
-            }
-        }
-    }
-    if (m["AA"].in == Position{ 0,0 }) {
-        m["AA"].in = m["AA"].out;
-    }
-    else
-        m["AA"].out = m["AA"].in;
+// portal tiles plus AA and ZZ: the nodes of the contracted graph
+const auto isPortalNode = [](Donut const& donut, uint32_t tile) {
+    return donut.portals.partner[tile] != gridbfs::Portals::NONE || tile == donut.start || tile == donut.end;
+};
 
-    if (m["ZZ"].in == Position{ 0,0 }) {
-        m["ZZ"].in = m["ZZ"].out;
+// Deepest level any solver needs to look at. Shortest paths are found at whatever depth they need;
+// depths beyond nodes^2 are only cut so that an unsolvable maze terminates - a one-counter system
+// with n states that can come back to level 0 at all can do so without its counter exceeding that bound.
+const auto depthLimit = [](uint64_t nodes) { return nodes * nodes; };
+
+const auto contractDonut = [](Donut const& donut) {
+    PortalGraph graph;
+    // node index per tile, -1 for tiles that are not portal nodes: read for every cell every BFS visits
+    std::vector<int> nodeOf(donut.grid.size(), -1);
+    for (auto tile = 0u; tile < donut.grid.size(); ++tile) {
+        if (!isPortalNode(donut, tile)) continue;
+        nodeOf[tile] = static_cast<int>(graph.nodes.size());
+        graph.nodes.emplace_back().tile = tile;
     }
-    else
-        m["ZZ"].out = m["ZZ"].in;
-
-    for (auto& e: m) {
-        if (e.first != "AA" && e.first != "ZZ") {
-            portals[e.second.in] = e.second.out;
-            portals[e.second.out] = e.second.in;
+    graph.start = nodeOf[donut.start];
+    graph.end = nodeOf[donut.end];
+    for (auto& node : graph.nodes) {
+        if (donut.portals.partner[node.tile] != gridbfs::Portals::NONE) {
+            node.partner = nodeOf[donut.portals.partner[node.tile]];
+            node.depthChange = donut.portals.levelChange[node.tile];
         }
+        gridbfs::bfs(donut.grid, node.tile, isOpen, [&](uint32_t tile, uint32_t, int32_t distance) {
+            if (distance > 0 && nodeOf[tile] != -1) node.walks.push_back({ nodeOf[tile], distance });
+            return false;
+        });
     }
+    return graph;
 };
 
-int bfs(map_type& map, Position startingPos, Position endPos) {
-    std::queue<Position> q;
-    const auto MAX_DEPTH = m.size() - 1;
-    std::array<int, 4> x_dir = { -1, 0 ,0, 1 };
-    std::array<int, 4> y_dir = { 0, -1 ,1, 0 };
-    std::vector<std::set<std::tuple<int, int>>> visited(MAX_DEPTH + 1);
-
-    visited[0].emplace(startingPos.x, startingPos.y);
-    q.push(startingPos);
-
-    while (not q.empty()) {
-        auto move = q.front();
-        q.pop();
-
-        if (move == endPos && move.level == 0) {
-            return move.steps-1;
-        }
-
-
-        for (int i = 0; i < 4; ++i) {
-
-            auto x = move.x + x_dir[i];
-            auto y = move.y + y_dir[i];
-            auto level = move.level;
-
-            if (visited[level].count(std::make_tuple(x,y)) > 0) continue;
-            if (x >= maps[level].size() || y >= maps[level][0].size()) continue;
-            const char c = maps[level][x][y];
-            if ( c == '#') continue;
-
-            if (c == '.'){
-                q.push({x,y, move.steps +1, level});
-                visited[level].emplace(x, y);
-            }
-            else if (c >= 'A' && c <= 'Z' && portals.count({x,y})) {
-                auto newPos = portals[{x,y}];
-                newPos.steps = move.steps;
-                level += depth_change[{x,y}];
-                if (level > MAX_DEPTH) level = MAX_DEPTH;
-                else if (level < 0) continue;
-                newPos.level = level;
-                q.push(newPos);
-                visited[level].emplace(newPos.x, newPos.y);
-            }
+// Dijkstra over (portal tile, depth) with no per-level copy of anything: memory grows with the
+// states actually reached. Depths are cut at depthLimit.
+uint64_t expandedStates = 0;
+
+int32_t shortestPath(PortalGraph const& graph, bool recursive) {
+    using State = std::pair<int32_t, uint64_t>;
+    const auto pack = [](uint64_t node, uint64_t depth) { return node | depth << 16; };
+    const auto maxDepth = depthLimit(graph.nodes.size());
+
+    FlatHashMap<int32_t> best;
+    std::priority_queue<State, std::vector<State>, std::greater<>> q;
+    const auto relax = [&](uint64_t state, int32_t distance) {
+        auto [stored, inserted] = best.tryEmplace(state, distance);
+        if (!inserted) {
+            if (*stored <= distance) return;
+            *stored = distance;
         }
+        q.push({ distance, state });
+    };
 
+    relax(pack(graph.start, 0), 0);
+    while (!q.empty()) {
+        const auto [distance, state] = q.top();
+        q.pop();
+        if (*best.find(state) < distance) continue;
+        ++expandedStates;
+        const auto node = static_cast<int>(state & 0xffff);
+        const auto depth = state >> 16;
+        if (node == graph.end && depth == 0) return distance;
+
+        auto const& current = graph.nodes[node];
+        for (const auto& [next, length] : current.walks)
+            relax(pack(next, depth), distance + length);
+
+        if (current.partner < 0) continue;
+        const auto nextDepth = recursive ? static_cast<int64_t>(depth) + current.depthChange : 0;
+        if (nextDepth < 0 || static_cast<uint64_t>(nextDepth) > maxDepth) continue;
+        relax(pack(current.partner, nextDepth), distance + 1);
     }
     return -1;
 }
@@ -264,23 +175,34 @@ int main(int argc, char** argv)
     }
 
     const std::string path = argv[1];
-    auto input = loadData(path);
-    searchPortals(input);
-    auto map = input;
-    auto startingPos = m["AA"].in;
-    auto ending = getEndingPos(input);
-
-    for (auto& entry: m) {
-        std::cout << entry.first << '\t'
-                  << '(' << entry.second.out.x << ',' << entry.second.out.y << ')'
-                  << ", " << entry.second.in.x << ',' << entry.second.in.y << ")\n";
+    const auto input = gridfile::load(path);
+    auto donut = parseDonut(input);
+
+    // a single solver, printed as "<answer> <states expanded>" for bench/maze_sweep
+    if (argc > 2) {
+        const std::string variant = argv[2];
+        donut.portals.recursive = variant.ends_with("-recursive");
+        // the grid searches get the same depth cut as dijkstra, so all variants search the same states
+        uint64_t nodes = 0;
+        for (auto tile = 0u; tile < donut.grid.size(); ++tile) nodes += isPortalNode(donut, tile);
+        donut.portals.maxLevel = donut.portals.recursive
+            ? static_cast<int32_t>(std::min<uint64_t>(depthLimit(nodes), std::numeric_limits<int32_t>::max())) : -1;
+        gridbfs::SearchResult result;
+        if (variant.starts_with("bfs")) result = gridbfs::shortestPath(donut.grid, isOpen, donut.start, donut.end, &donut.portals);
+        else if (variant.starts_with("bidirectional")) result = gridbfs::shortestPathBidirectional(donut.grid, isOpen, donut.start, donut.end, &donut.portals);
+        else if (variant.starts_with("dijkstra")) result = { shortestPath(contractDonut(donut), donut.portals.recursive), expandedStates };
+        else {
+            std::cout << "unknown variant " << variant << '\n';
+            return -1;
+        }
+        std::cout << result.distance << ' ' << result.expanded << '\n';
+        return 0;
     }
 
-    for (auto i = 0u; i < m.size() - 1 /*except ZZ portal*/; ++i) {
-        maps.push_back(input);
-    }
-    map = input;
-    std::cout << bfs(map, startingPos, ending) << '\n';
+    // a single flat start-goal distance: meet in the middle on the grid itself
+    std::cout << "First puzzle answer: "
+              << gridbfs::shortestPathBidirectional(donut.grid, isOpen, donut.start, donut.end, &donut.portals).distance << '\n';
+    std::cout << "Second puzzle answer: " << shortestPath(contractDonut(donut), true) << '\n';
 
     //516  - OK
     //5966 - OK
@@ -14,6 +14,11 @@
 #include <stack>
 #include <cassert>
 #include <queue>
+#include <bitset>
+#include <unordered_set>
+#include <unordered_map>
+#include <sstream>
+#include <type_traits>
 
 namespace {
 
@@ -69,6 +74,7 @@ namespace {
         bool isDebugEnabled{ true };
         bool shallOutputBreakExecution{ true };
         bool isAsciiModeEnabled{ false };
+        bool isEchoEnabled{ true };
 
     public:
     std::queue<int> instructions;
@@ -82,6 +88,10 @@ namespace {
             isAsciiModeEnabled = val;
         }
 
+        void setEcho(bool val) {
+            isEchoEnabled = val;
+        }
+
         void updateMemoryLocation(size_t pos, int64_t value) {
             memory[pos] = value;
         }
@@ -190,10 +200,12 @@ namespace {
                     answer = val;
                     if (shallOutputBreakExecution)
                         shouldBrake = true;
-                    if (isAsciiModeEnabled) {
-                        std::cout << static_cast<char>(val);
+                    if (isEchoEnabled) {
+                        if (isAsciiModeEnabled) {
+                            std::cout << static_cast<char>(val);
+                        }
+                        else std::cout << val << ',' << ' ';
                     }
-                    else std::cout << val << ',' << ' ';
                     ip += 2;
                     ++counter;
                     break;
@@ -341,6 +353,335 @@ namespace {
             return false;
         }
     };
+
+    enum class SpringOp { AND, OR, NOT };
+
+    // registers 0..8 are the sensors A..I, followed by the writable T and J
+    constexpr auto MAX_SENSORS = 9;
+    constexpr auto REG_T = MAX_SENSORS;
+    constexpr auto REG_J = MAX_SENSORS + 1;
+
+    struct SpringInstruction {
+        SpringOp op;
+        int src;
+        int dst;
+    };
+
+    using SpringProgram = std::vector<SpringInstruction>;
+
+    std::string toSpringScript(SpringProgram const& program, bool run) {
+        std::string script;
+        for (auto& i : program) {
+            script += i.op == SpringOp::AND ? "AND " : i.op == SpringOp::OR ? "OR " : "NOT ";
+            script += i.src == REG_T ? 'T' : i.src == REG_J ? 'J' : static_cast<char>('A' + i.src);
+            script += i.dst == REG_T ? " T\n" : " J\n";
+        }
+        script += run ? "RUN\n" : "WALK\n";
+        return script;
+    }
+
+    // One bit per sensor window: bit i of a window is set when there is ground i + 1 tiles ahead.
+    // Evaluating a program on tables runs it for all windows at once.
+    using SpringTable = std::bitset<1 << MAX_SENSORS>;
+
+    template <typename Table>
+    Table springCombine(SpringOp op, Table const& dst, Table const& src) {
+        switch (op) {
+        case SpringOp::AND: return dst & src;
+        case SpringOp::OR:  return dst | src;
+        case SpringOp::NOT: return ~src;
+        }
+        return dst;
+    }
+
+    void springStep(std::array<SpringTable, REG_J + 1>& regs, SpringInstruction i) {
+        regs[i.dst] = springCombine(i.op, regs[i.dst], regs[i.src]);
+    }
+
+    // Local springdroid, replaying hulls the real one fell into.
+    class SpringSimulator {
+    public:
+        explicit SpringSimulator(int sensors) : sensors(sensors) {}
+
+        void addHull(std::string const& hull) {
+            hulls.push_back(hull);
+        }
+
+        size_t hullCount() const { return hulls.size(); }
+
+        int windowAt(std::string const& hull, size_t pos) const {
+            auto pattern = 0;
+            for (auto i = 0; i < sensors; ++i) {
+                const auto at = pos + 1 + i;
+                pattern |= (at >= hull.size() || hull[at] == '#') << i;
+            }
+            return pattern;
+        }
+
+        // jump decision for every one of the 2^sensors windows
+        SpringTable evaluate(SpringProgram const& program) const {
+            std::array<SpringTable, REG_J + 1> regs{};
+            for (auto w = 0; w < (1 << sensors); ++w)
+                for (auto i = 0; i < sensors; ++i) regs[i][w] = (w >> i) & 1;
+            for (auto& i : program) springStep(regs, i);
+            return regs[REG_J];
+        }
+
+        bool survives(SpringTable const& jump) const {
+            for (auto& hull : hulls) {
+                auto pos = 0u;
+                while (pos < hull.size()) {
+                    pos += jump[windowAt(hull, pos)] ? 4 : 1;
+                    if (pos < hull.size() && hull[pos] == '.') return false;
+                }
+            }
+            return true;
+        }
+
+        // Backtracking over jump/walk choices, shared by all hulls: a window decided on one hull is
+        // decided everywhere. Returns the decisions for the windows the droid actually sees.
+        std::optional<std::map<int, bool>> label() const {
+            std::map<int, bool> decisions;
+            if (!label(decisions, 0, 0)) return {};
+            return decisions;
+        }
+
+    private:
+        bool label(std::map<int, bool>& decisions, size_t hull, size_t pos) const {
+            if (hull == hulls.size()) return true;
+            auto& ground = hulls[hull];
+            if (pos >= ground.size()) return label(decisions, hull + 1, 0);
+            if (ground[pos] == '.') return false;
+
+            const auto window = windowAt(ground, pos);
+            if (auto it = decisions.find(window); it != decisions.end())
+                return label(decisions, hull, pos + (it->second ? 4 : 1));
+
+            // prefer the natural policy - walk on solid ground, jump as soon as a hole shows up within
+            // three tiles - since decisions following one simple rule make for short scripts
+            const auto holeAhead = (window & 0b111) != 0b111;
+            for (auto jump : { holeAhead, !holeAhead }) {
+                decisions[window] = jump;
+                if (label(decisions, hull, pos + (jump ? 4 : 1))) return true;
+            }
+            decisions.erase(window);
+            return false;
+        }
+
+        int sensors;
+        std::vector<std::string> hulls;
+    };
+
+    // Shortest program whose J matches `labels` on the labelled windows, all other windows being don't-care.
+    // Tables only keep the labelled windows (bit k = k-th label), which is what makes deduplicating
+    // states effective; up to 64 labels fit a plain uint64_t.
+    //
+    // Uniform-cost search over J tables. A step is either one instruction applied to J with a sensor,
+    // or a self-contained T term folded into J with AND/OR/NOT T J. Forgetting T between steps keeps
+    // the state space to distinct J values; the result is shortest within that program shape.
+    template <typename Table>
+    class SpringSynthesizer {
+    public:
+        SpringSynthesizer(std::map<int, bool> const& labels, int sensors, size_t maxTermLength)
+            : sensors(sensors) {
+            auto k = 0;
+            for (auto [window, jump] : labels) {
+                for (auto i = 0; i < sensors; ++i) setBit(sensorTables[i], k, (window >> i) & 1);
+                setBit(care, k, true);
+                setBit(target, k, jump);
+                ++k;
+            }
+            terms[0] = buildTerms(true, maxTermLength);
+            terms[1] = buildTerms(false, maxTermLength);
+        }
+
+        // iterative deepening on the length bound: programs of exactly the bound are only checked, never
+        // stored, which keeps memory to the states one instruction short of the answer
+        std::optional<SpringProgram> run(size_t maxLength) {
+            for (auto bound = 1u; bound <= maxLength; ++bound) {
+                if (auto program = search(bound)) return program;
+            }
+            return {};
+        }
+
+    private:
+        using Terms = std::vector<std::pair<Table, SpringProgram>>;
+
+        struct Node {
+            Table j;
+            int parent;
+            int16_t term;   // index into terms[parent's tUsed], -1 for a direct J instruction
+            bool tUsed;
+            SpringInstruction instruction;
+        };
+
+        SpringProgram programOf(std::vector<Node> const& nodes, Node node) const {
+            SpringProgram program;
+            while (node.parent >= 0) {
+                program.insert(program.begin(), node.instruction);
+                auto& parent = nodes[node.parent];
+                if (node.term >= 0) {
+                    auto& term = terms[parent.tUsed][node.term].second;
+                    program.insert(program.begin(), term.begin(), term.end());
+                }
+                node = parent;
+            }
+            return program;
+        }
+
+        std::optional<SpringProgram> search(size_t bound) {
+            std::vector<Node> nodes = { { Table{}, -1, -1, false, {} } };
+            std::array<std::unordered_map<Table, uint8_t>, 2> best;
+            std::vector<std::vector<int>> buckets(bound);
+            best[0][Table{}] = 0;
+            buckets[0].push_back(0);
+
+            std::optional<Node> goal;
+            size_t goalCost = bound + 1;
+
+            const auto push = [&](Table const& j, bool tUsed, int parent, int term, SpringInstruction instruction, size_t cost) {
+                if (cost >= goalCost) return;
+                const Node node{ j, parent, static_cast<int16_t>(term), tUsed, instruction };
+                if (j == target) {
+                    goal = node;
+                    goalCost = cost;
+                    return;
+                }
+                if (cost >= bound) return;
+                auto [it, inserted] = best[tUsed].try_emplace(j, cost);
+                if (!inserted) {
+                    if (it->second <= cost) return;
+                    it->second = cost;
+                }
+                nodes.push_back(node);
+                buckets[cost].push_back(nodes.size() - 1);
+            };
+
+            for (auto cost = 0u; cost < bound && cost + 1 < goalCost; ++cost) {
+                for (auto i = 0u; i < buckets[cost].size(); ++i) {
+                    const auto n = buckets[cost][i];
+                    const auto j = nodes[n].j;
+                    const auto tUsed = nodes[n].tUsed;
+                    if (best[tUsed][j] < cost) continue;
+
+                    for (auto op : { SpringOp::AND, SpringOp::OR, SpringOp::NOT }) {
+                        for (auto src = 0; src < sensors; ++src)
+                            push(springCombine(op, j, sensorTables[src]) & care, tUsed, n, -1, { op, src, REG_J }, cost + 1);
+                        for (auto k = 0u; k < terms[tUsed].size(); ++k) {
+                            auto& [t, term] = terms[tUsed][k];
+                            push(springCombine(op, j, t) & care, true, n, k, { op, REG_T, REG_J }, cost + term.size() + 1);
+                        }
+                    }
+                    push(~j & care, tUsed, n, -1, { SpringOp::NOT, REG_J, REG_J }, cost + 1);
+                }
+            }
+            if (goal) return programOf(nodes, *goal);
+            return {};
+        }
+
+
+        static void setBit(Table& t, int k, bool value) {
+            if constexpr (std::is_integral_v<Table>) t |= static_cast<Table>(value) << k;
+            else t[k] = value;
+        }
+
+        // Every distinct T value buildable with at most `maxLength` instructions touching only T, each
+        // with its cheapest sequence. `fromZero` starts from the untouched all-false T, otherwise the
+        // first instruction has to overwrite whatever T holds (NOT X T).
+        Terms buildTerms(bool fromZero, size_t maxLength) const {
+            Terms all;
+            Terms level;
+            std::unordered_set<Table> seen;
+            const auto extend = [&](Table const& t, SpringProgram const& program, SpringInstruction i, Terms& out) {
+                const auto nt = springCombine(i.op, t, i.src == REG_T ? t : sensorTables[i.src]) & care;
+                if (!seen.insert(nt).second) return;
+                auto extended = program;
+                extended.push_back(i);
+                out.push_back({ nt, std::move(extended) });
+            };
+
+            for (auto src = 0; src < sensors; ++src) {
+                for (auto op : { SpringOp::AND, SpringOp::OR, SpringOp::NOT }) {
+                    if (op == SpringOp::NOT || fromZero) extend(Table{}, {}, { op, src, REG_T }, level);
+                }
+            }
+            for (auto length = 1u; length <= maxLength && !level.empty(); ++length) {
+                all.insert(all.end(), level.begin(), level.end());
+                if (length == maxLength) break;
+                Terms next;
+                for (auto& [t, program] : level) {
+                    for (auto op : { SpringOp::AND, SpringOp::OR, SpringOp::NOT }) {
+                        for (auto src = 0; src < sensors; ++src) extend(t, program, { op, src, REG_T }, next);
+                        if (op == SpringOp::NOT) extend(t, program, { op, REG_T, REG_T }, next);
+                    }
+                }
+                level = std::move(next);
+            }
+            return all;
+        }
+
+        int sensors;
+        std::array<Table, MAX_SENSORS> sensorTables{};
+        Table care{};
+        Table target{};
+        std::array<Terms, 2> terms;
+    };
+
+    std::optional<SpringProgram> synthesize(std::map<int, bool> const& labels, int sensors, size_t maxLength = 15, size_t maxTermLength = 2) {
+        if (labels.size() <= 64) return SpringSynthesizer<uint64_t>(labels, sensors, maxTermLength).run(maxLength);
+        return SpringSynthesizer<SpringTable>(labels, sensors, maxTermLength).run(maxLength);
+    }
+
+    struct SpringRun {
+        std::optional<int64_t> damage;
+        std::string failedHull;
+    };
+
+    SpringRun runSpringdroid(IntCodeComputer pc, std::string const& script) {
+        pc.disableDebug();
+        pc.setEcho(false);
+        for (auto ch : script) pc.instructions.push(ch);
+
+        std::string screen;
+        while (true) {
+            auto [val, opCode, _] = pc.run(0);
+            if (opCode == OpCodes::STOP) break;
+            if (val > 127) return { val, {} };
+            screen.push_back(static_cast<char>(val));
+        }
+
+        // the droid fell: the last line drawn made only of '#' and '.' is the hull it walked on
+        SpringRun result;
+        std::istringstream lines(screen);
+        for (std::string line; std::getline(lines, line);) {
+            if (!line.empty() && line.find_first_not_of("#.") == std::string::npos && line.find('#') != std::string::npos)
+                result.failedHull = line;
+        }
+        return result;
+    }
+
+    // synthesize against the known hulls, hand only the candidate to the VM, learn from its failure
+    std::optional<int64_t> solveSpringdroid(IntCodeComputer const& pc, int sensors, std::vector<std::string> const& knownHulls) {
+        SpringSimulator sim(sensors);
+        for (auto& h : knownHulls) sim.addHull(h);
+
+        while (true) {
+            const auto labels = sim.label();
+            if (!labels) return {};
+            const auto program = synthesize(*labels, sensors);
+            if (!program || !sim.survives(sim.evaluate(*program))) return {};
+            const auto script = toSpringScript(*program, sensors > 4);
+            const auto result = runSpringdroid(pc, script);
+            std::cout << "candidate with " << program->size() << " instructions against " << sim.hullCount() << " hulls: "
+                      << (result.damage ? "survived" : "fell into " + result.failedHull) << '\n';
+            if (result.damage) {
+                std::cout << script;
+                return result.damage;
+            }
+            if (result.failedHull.empty()) return {};
+            sim.addHull(result.failedHull);
+        }
+    }
 }
 
 int main()
@@ -349,38 +690,26 @@ int main()
     };
 
     IntCodeComputer pc(input);
-    pc.disableDebug();
-    //pc.setAsciiMode(true);
-    /*
-    first puzzle answer
-        NOT A J\n\
-        OR T J\n\
-        NOT B T\n\
-        OR T J\n\
-        NOT C T\n\
-        OR T J\n\
-        AND D J\n\
-    */
-    const std::string s = "\
-        NOT A J\n\
-        OR T J\n\
-        NOT B T\n\
-        OR T J\n\
-        NOT C T\n\
-        OR T J\n\
-        AND D J\n\
-        NOT H T\n\
-        NOT T T\n\
-        OR E T\n\
-        AND T J\n\
-        RUN\n";
-    
-    for (auto ch: s) {
-        pc.instructions.push(static_cast<int>(ch));
-    }
-    while(true) {
-        auto opCode = std::get<1>(pc.run(0));
-        if (opCode == OpCodes::STOP) break;
-    }
+
+    // hulls the droid fell into on earlier runs; any missing one is learned from a failed VM run
+    const std::vector<std::string> walkHulls = {
+        "#####.###########",
+        "#####...#########",
+        "#####.#.#########",
+    };
+    const std::vector<std::string> runHulls = {
+        "#####.###########",
+        "#####...#########",
+        "#####.#.#########",
+        "#####.#.#..##.###",
+        "#####.#...#.#.###",
+        "#####.##.#.##.###",
+        "#####.#.#.##.####",
+    };
+
+    if (const auto damage = solveSpringdroid(pc, 4, walkHulls))
+        std::cout << "First puzzle answer: " << *damage << '\n';
+    if (const auto damage = solveSpringdroid(pc, 9, runHulls))
+        std::cout << "Second puzzle answer: " << *damage << '\n';
     return 0;
 }
@@ -20,6 +20,15 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <numeric>
+#include <cstdint>
+#include <utility>
+#include <limits>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "../common/instrument.hpp"
 
 
 namespace{
@@ -34,7 +43,6 @@ enum class task {
 };
 
 using data_type = std::vector<std::pair<task, int32_t>>;
-using deck = std::vector<int32_t>;
 
 const auto loadData = [](auto path){
     data_type res;
@@ -55,25 +63,177 @@ const auto loadData = [](auto path){
     return res;
 };
 
-const auto handleNewStack = [](deck& d) {
-    std::reverse(d.begin(), d.end());
+// Every technique moves the card at position x to a*x + b (mod deck size): a new stack is
+// -x - 1, a cut by n is x - n and an increment k is k*x. Such maps compose into one of the same
+// form, so the whole instruction list becomes a single pair (a, b) and a query costs a couple of
+// multiplications, whatever the deck size. Products go through 128 bits, so any size below 2^63
+// works, the 119315717514047 cards of part two included.
+inline uint64_t mulMod(uint64_t x, uint64_t y, uint64_t m) {
+    return static_cast<uint64_t>(static_cast<unsigned __int128>(x) * y % m);
+}
+
+inline uint64_t toResidue(int64_t value, uint64_t m) {
+    const auto r = value % static_cast<int64_t>(m);
+    return static_cast<uint64_t>(r < 0 ? r + static_cast<int64_t>(m) : r);
+}
+
+// extended Euclid; none when x and m share a factor
+inline std::optional<uint64_t> inverseMod(uint64_t x, uint64_t m) {
+    int64_t r0 = static_cast<int64_t>(m), r1 = static_cast<int64_t>(x % m);
+    int64_t t0 = 0, t1 = 1;
+    while (r1 != 0) {
+        const auto q = r0 / r1;
+        r0 = std::exchange(r1, r0 - q * r1);
+        t0 = std::exchange(t1, t0 - q * t1);
+    }
+    if (r0 != 1) return std::nullopt;
+    return toResidue(t0, m);
+}
+
+struct Affine {
+    uint64_t a{ 1 };
+    uint64_t b{ 0 };
+    uint64_t size{ 1 };
+
+    uint64_t operator()(uint64_t x) const { return (mulMod(a, x, size) + b) % size; }
+
+    // this map first, then `next`
+    Affine then(Affine const& next) const {
+        return { mulMod(next.a, a, size), (mulMod(next.a, b, size) + next.b) % size, size };
+    }
+
+    // the map applied k times, by squaring: O(log k) compositions
+    Affine power(uint64_t k) const {
+        Affine result{ 1, 0, size };
+        for (auto square = *this; k > 0; k >>= 1, square = square.then(square))
+            if (k & 1) result = result.then(square);
+        return result;
+    }
+
+    // x = a^-1 * (y - b)
+    std::optional<Affine> inverse() const {
+        const auto inv = inverseMod(a, size);
+        if (!inv) return std::nullopt;
+        return Affine{ *inv, mulMod(*inv, (size - b) % size, size), size };
+    }
+};
+
+const auto techniqueMap = [](std::pair<task, int32_t> const& t, uint64_t size) -> Affine {
+    switch (t.first) {
+        case task::stack: return { size - 1, size - 1, size };
+        case task::cut: return { 1, toResidue(-static_cast<int64_t>(t.second), size), size };
+        case task::inc: return { toResidue(t.second, size), 0, size };
+    }
+    return { 1, 0, size };
+};
+
+const auto composeShuffle = [](data_type const& data, uint64_t size) {
+    Affine shuffle{ 1, 0, size };
+    for (auto& e : data)
+        shuffle = shuffle.then(techniqueMap(e, size));
+    return shuffle;
+};
+
+// position of a card after the shuffle, and the card that ends up at a position
+struct ShuffleQueries {
+    Affine forward;
+    Affine backward;
+
+    uint64_t positionOf(uint64_t card) const { return forward(card); }
+    uint64_t cardAt(uint64_t position) const { return backward(position); }
 };
 
-const auto handleCut = [](deck& d, const auto len) {
-    if (len > 0) std::rotate(d.begin(), d.begin() + len, d.end());
-    else std::rotate(d.rbegin(), d.rbegin() + std::abs(len), d.rend());
+// the shuffle repeated `times` times; inverting once and raising the inverse is the same as
+// inverting the power, and keeps both directions O(log times) to build
+const auto makeQueries = [](Affine const& shuffle, uint64_t times = 1) -> std::optional<ShuffleQueries> {
+    const auto backward = shuffle.inverse();
+    if (!backward) return std::nullopt;
+    return ShuffleQueries{ shuffle.power(times), backward->power(times) };
 };
 
-const auto handleIncrement = [](deck& d, const auto step) {
-    deck res (d.size());
-    std::size_t j = 0;
-    for (auto i = 0u; i < d.size(); ++i) {
-        res[j] = d[i];
-        j += step;
-        j %= d.size();
+// The whole deck, for when the order itself is wanted (checks, pictures): cards live in one of two
+// preallocated buffers and a technique that cannot work in place writes the next order into the
+// other one and swaps them, so a shuffle allocates nothing. An increment k is run as a gather,
+// new[j] = old[j * k^-1], with the index advanced by an add and a conditional subtract instead
+// of a modulo, eight lanes at a time with AVX2. Sizes up to 2^31 - 1 keep indices in 32 bits.
+class DeckShuffler {
+public:
+    explicit DeckShuffler(uint32_t size) : cards(size), spare(size) { std::iota(cards.begin(), cards.end(), 0u); }
+
+    std::vector<uint32_t> const& order() const { return cards; }
+
+    void newStack() { std::reverse(cards.begin(), cards.end()); }
+
+    void cut(int64_t n) {
+        const auto shift = toResidue(n, cards.size());
+        std::rotate_copy(cards.begin(), cards.begin() + shift, cards.end(), spare.begin());
+        std::swap(cards, spare);
+    }
+
+    // false when k shares a factor with the size (not a permutation)
+    bool increment(int64_t k) {
+        const auto size = static_cast<uint32_t>(cards.size());
+        const auto inverse = inverseMod(toResidue(k, size), size);
+        if (!inverse) return false;
+        const auto step = static_cast<uint32_t>(*inverse);
+        const auto* from = cards.data();
+        auto* to = spare.data();
+        uint32_t j = 0;
+        uint32_t index = 0;      // j * step mod size
+#ifdef __AVX2__
+        if (size >= 8) {
+            alignas(32) std::array<uint32_t, 8> lanes;
+            for (auto lane = 0u; lane < 8; ++lane) lanes[lane] = static_cast<uint32_t>(mulMod(lane, step, size));
+            auto indices = _mm256_load_si256(reinterpret_cast<__m256i const*>(lanes.data()));
+            const auto sizes = _mm256_set1_epi32(static_cast<int32_t>(size));
+            // i + 8 step - size lies in (-size, size): add size back where it went negative
+            const auto back = _mm256_set1_epi32(static_cast<int32_t>(size - mulMod(8, step, size)));
+            for (; j + 8 <= size; j += 8) {
+                const auto gathered = _mm256_i32gather_epi32(reinterpret_cast<int const*>(from), indices, 4);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(to + j), gathered);
+                const auto t = _mm256_sub_epi32(indices, back);
+                indices = _mm256_add_epi32(t, _mm256_and_si256(sizes, _mm256_srai_epi32(t, 31)));
+            }
+            index = static_cast<uint32_t>(mulMod(j, step, size));
+        }
+#endif
+        for (; j < size; ++j) {
+            to[j] = from[index];
+            index += step;
+            if (index >= size) index -= size;
+        }
+        std::swap(cards, spare);
+        return true;
+    }
+
+    bool apply(data_type const& data) {
+        for (auto& e : data) {
+            if (e.first == task::stack) {
+                INSTRUMENT_SCOPE("day22 deck new stack", cards.size());
+                newStack();
+            }
+            else if (e.first == task::cut) {
+                INSTRUMENT_SCOPE("day22 deck cut", cards.size());
+                cut(e.second);
+            }
+            else {
+                INSTRUMENT_SCOPE("day22 deck increment", cards.size());
+                if (!increment(e.second)) return false;
+            }
+        }
+        return true;
     }
-    d = res;
+
+private:
+    std::vector<uint32_t> cards;
+    std::vector<uint32_t> spare;
 };
+
+// toResidue and inverseMod work in int64_t, which caps the affine deck size
+constexpr uint64_t MAX_DECK = static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+
+constexpr uint64_t HUGE_DECK = 119315717514047;
+constexpr uint64_t HUGE_SHUFFLES = 101741582076661;
 }
 
 int main(int argc, char** argv) {
@@ -84,22 +244,71 @@ int main(int argc, char** argv) {
 
     const std::string path = argv[1];
     const auto data = loadData(path);
-    std::vector<int32_t> v(10007);
-    std::iota(v.begin(), v.end(), 0);
-
 
-    for (auto& e: data) {
-        if (e.first == task::stack) {
-            handleNewStack(v);
+    // "position <deck size> <card> [shuffles]" / "card <deck size> <position> [shuffles]": a single
+    // query on any deck; "batch [queries] [shuffles]": card-at-position throughput on the huge deck
+    const std::string mode = argc > 2 ? argv[2] : "";
+    if (mode == "position" || mode == "card") {
+        if (argc < 5) {
+            std::cout << "too few parameters\n";
+            return -1;
+        }
+        const auto size = std::stoull(argv[3]);
+        if (size == 0 || size > MAX_DECK) {
+            std::cout << "deck size must be between 1 and 2^63 - 1\n";
+            return -1;
         }
-        else if (e.first == task::cut) {
-            handleCut(v, e.second);
+        const auto value = std::stoull(argv[4]) % size;
+        const auto queries = makeQueries(composeShuffle(data, size), argc > 5 ? std::stoull(argv[5]) : 1);
+        if (!queries) {
+            std::cout << "an increment shares a factor with the deck size, the shuffle is not a permutation\n";
+            return -1;
         }
-        else if (e.first == task::inc) {
-            handleIncrement(v, e.second);
+        std::cout << (mode == "position" ? queries->positionOf(value) : queries->cardAt(value)) << '\n';
+        return 0;
+    }
+
+    if (mode == "batch") {
+        const auto count = argc > 3 ? std::stoull(argv[3]) : 10'000'000ull;
+        const auto times = argc > 4 ? std::stoull(argv[4]) : HUGE_SHUFFLES;
+        const auto queries = makeQueries(composeShuffle(data, HUGE_DECK), times);
+        if (!queries) return -1;
+        // positions from a cheap LCG; the checksum keeps the loop from being optimised away
+        uint64_t position = 2020, checksum = 0;
+        {
+            INSTRUMENT_SCOPE("day22 card-at queries", count);
+            for (auto i = 0ull; i < count; ++i) {
+                position = (position * 6364136223846793005ull + 1442695040888963407ull) % HUGE_DECK;
+                checksum ^= queries->cardAt(position);
+            }
         }
+        std::cout << count << " queries, checksum " << checksum << '\n';
+        return 0;
     }
 
-    std::cout << "First puzzle: " << std::distance(v.begin(), std::find(v.begin(), v.end(), 2019)) << '\n';
+    std::cout << "First puzzle: " << composeShuffle(data, 10007)(2019) << '\n';
+    if (const auto queries = makeQueries(composeShuffle(data, HUGE_DECK), HUGE_SHUFFLES))
+        std::cout << "Second puzzle: " << queries->cardAt(2020) << '\n';
+    if (mode != "deck") return 0;
+
+    // "deck [size]": the full permutation, checked against the composed map
+    const auto requested = argc > 3 ? std::stoull(argv[3]) : 10007ull;
+    if (requested == 0 || requested > static_cast<uint64_t>(std::numeric_limits<int32_t>::max())) {
+        std::cout << "deck size must be between 1 and 2^31 - 1\n";
+        return -1;
+    }
+    const auto size = static_cast<uint32_t>(requested);
+    DeckShuffler shuffler(size);
+    if (!shuffler.apply(data)) {
+        std::cout << "an increment shares a factor with the deck size, the shuffle is not a permutation\n";
+        return -1;
+    }
+    const auto shuffle = composeShuffle(data, size);
+    auto mismatches = 0ull;
+    for (auto position = 0u; position < size; position += std::max(1u, size / 100000))
+        mismatches += shuffle(shuffler.order()[position]) != position;
+    if (size == 10007)
+        std::cout << "First puzzle (deck): " << std::distance(shuffler.order().begin(), std::find(shuffler.order().begin(), shuffler.order().end(), 2019u)) << '\n';
+    std::cout << size << " cards, " << mismatches << " sampled positions disagree with the composed map\n";
     return 0;
-}
\ No newline at end of file
+}
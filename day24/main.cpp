@@ -14,13 +14,13 @@
 #include <cassert>
 #include <queue>
 #include <list>
-#include <fstream>
 #include <thread>
 #include <chrono>
 #include <unordered_set>
 #include <unordered_map>
 #include <numeric>
 
+#include "../common/grid_file.hpp"
 
 namespace{
 
@@ -34,28 +34,6 @@ const auto getEmptyGrid = []{
     return g;
 };
 
-const auto loadData = [](auto path){
-    data_type res;
-    char ch;
-    bool insertNewLine = false;
-    std::fstream fs(path, std::fstream::in);
-    res.push_back({});
-    while (fs.get(ch)) {
-        if (insertNewLine) {
-            res.push_back({});
-            insertNewLine = false;
-        }
-        if (ch == '\n') {
-            insertNewLine = true;
-        }
-        else {
-            res.back().push_back(ch);
-        }
-    }
-    fs.close();
-    return res;
-};
-
 const auto print = [](data_type& d) {
     for (auto& line: d) {
         for (auto e: line) {
@@ -287,7 +265,12 @@ int main(int argc, char** argv) {
         std::cout << "too few parameters!\n";
         return -1;
     }
-    auto input = loadData(argv[1]);
+    const auto file = gridfile::load(argv[1]);
+    if (file.size() != 5 || file.width() != 5 || !file.rectangular()) {
+        std::cout << "expected a 5x5 grid of bugs\n";
+        return -1;
+    }
+    auto input = file.copy<data_type>();
     auto data = input;
     std::set<std::string> layouts;
 